@@ -0,0 +1,531 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+/**
+ * Benchmarks for r3dvis (built with -DBUILD_BENCHMARKS=ON).
+ *
+ * Synthetic icospheres and grids of increasing face count (with and without a texture)
+ * are used to time actor creation, surface mapping, texture conversion, conversion back
+ * to meshes, offscreen snapshots and picking. Rendering uses offscreen software rendering
+ * (Mesa's llvmpipe where available) unless --hardware is given so timings are comparable
+ * across machines. Results are printed as a table and optionally written as JSON and/or
+ * CSV so they can be compared against a baseline to catch regressions.
+ *
+ * Usage: r3dvis_bench [--max-faces N] [--repeats R] [--json file] [--csv file] [--hardware]
+ */
+
+#include <r3dvis/OffscreenMeshViewer.h>
+#include <r3dvis/VtkActorCreator.h>
+#include <r3dvis/RendererPicker.h>
+#include <r3dvis/SurfaceMapper.h>
+#include <r3dvis/VtkTools.h>
+#include <r3dvis/MeshBVH.h>
+#include <r3dvis/Viewer.h>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstring>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+
+namespace {
+
+const size_t FACE_COUNTS[] = {10000, 100000, 1000000, 10000000};
+const int TEXTURE_SIZE = 1024;
+const cv::Size VIEWER_SIZE( 512, 512);
+const int NUM_PICKS = 100;          // Points for single point picking
+const int BATCH_SIDE = 100;         // BATCH_SIDE^2 points for batch picking
+const double PI = 3.14159265358979323846;
+
+struct Result
+{
+    std::string group;
+    std::string name;
+    std::string shape;
+    size_t faces;
+    bool textured;
+    double bestMs;
+    double medianMs;
+};  // end struct
+
+std::vector<Result> results;
+
+
+struct Timing
+{
+    double bestMs;
+    double medianMs;
+};  // end struct
+
+
+// Returns the best and median times in milliseconds over the given number of repeats.
+// If given, setup is called before each repeat outside of the timed region.
+Timing timeIt( const std::function<void()> &fn, int repeats, const std::function<void()> &setup=nullptr)
+{
+    std::vector<double> ts( repeats);
+    for ( int r = 0; r < repeats; ++r)
+    {
+        if ( setup)
+            setup();
+        const auto t0 = std::chrono::steady_clock::now();
+        fn();
+        const auto t1 = std::chrono::steady_clock::now();
+        ts[r] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    }   // end for
+    std::sort( ts.begin(), ts.end());
+    return Timing{ ts.front(), ts[ts.size()/2]};
+}   // end timeIt
+
+
+void report( const std::string &name, double ms, double baseMs=0)
+{
+    std::cout << "  " << std::left << std::setw(52) << name << std::right << std::setw(12)
+              << std::fixed << std::setprecision(2) << ms << " ms";
+    if ( baseMs > 0)
+        std::cout << "  (x" << std::setprecision(1) << baseMs / ms << ")";
+    std::cout << std::endl;
+}   // end report
+
+
+// Time the function and record the result against the given mesh description.
+Timing bench( const std::string &group, const std::string &name, const std::string &shape, size_t nfaces, bool textured,
+              const std::function<void()> &fn, int repeats, double baseMs=0)
+{
+    const Timing t = timeIt( fn, repeats);
+    results.push_back( Result{ group, name, shape, nfaces, textured, t.bestMs, t.medianMs});
+    report( group + "::" + name, t.bestMs, baseMs);
+    return t;
+}   // end bench
+
+
+// As bench but calls setup (untimed) before each repeat so every repeat starts from the same state.
+Timing benchEach( const std::string &group, const std::string &name, const std::string &shape, size_t nfaces, bool textured,
+                  const std::function<void()> &setup, const std::function<void()> &fn, int repeats)
+{
+    const Timing t = timeIt( fn, repeats, setup);
+    results.push_back( Result{ group, name, shape, nfaces, textured, t.bestMs, t.medianMs});
+    report( group + "::" + name, t.bestMs);
+    return t;
+}   // end benchEach
+
+
+// A flat square grid over [-1,1]^2 of side x side vertices with two triangles per cell.
+r3d::Mesh::Ptr makeGrid( int side)
+{
+    r3d::Mesh::Ptr mesh = r3d::Mesh::create();
+    const float step = 2.0f / (side-1);
+    for ( int i = 0; i < side; ++i)
+        for ( int j = 0; j < side; ++j)
+            mesh->addVertex( j*step - 1.0f, i*step - 1.0f, 0.0f);
+    for ( int i = 0; i < side-1; ++i)
+    {
+        for ( int j = 0; j < side-1; ++j)
+        {
+            const int v = i*side + j;
+            mesh->addFace( v, v+1, v+side+1);
+            mesh->addFace( v, v+side+1, v+side);
+        }   // end for
+    }   // end for
+    return mesh;
+}   // end makeGrid
+
+
+// A grid with at least the given number of faces.
+r3d::Mesh::Ptr makeGridFaces( size_t nfaces)
+{
+    const int side = int( ceil( sqrt( double(nfaces) / 2))) + 1;
+    return makeGrid( side);
+}   // end makeGridFaces
+
+
+// A unit icosphere with at least the given number of faces (and fewer than four times as
+// many) made by repeatedly splitting each face of an icosahedron into four (so 20*4^n faces).
+r3d::Mesh::Ptr makeIcosphere( size_t nfaces)
+{
+    const float t = (1.0f + sqrtf(5.0f)) / 2;
+    std::vector<r3d::Vec3f> vs = {
+        {-1, t, 0}, { 1, t, 0}, {-1,-t, 0}, { 1,-t, 0},
+        { 0,-1, t}, { 0, 1, t}, { 0,-1,-t}, { 0, 1,-t},
+        { t, 0,-1}, { t, 0, 1}, {-t, 0,-1}, {-t, 0, 1}};
+    for ( r3d::Vec3f &v : vs)
+        v.normalize();
+    std::vector<int> fs = {
+        0,11,5,  0,5,1,   0,1,7,   0,7,10,  0,10,11,
+        1,5,9,   5,11,4,  11,10,2, 10,7,6,  7,1,8,
+        3,9,4,   3,4,2,   3,2,6,   3,6,8,   3,8,9,
+        4,9,5,   2,4,11,  6,2,10,  8,6,7,   9,8,1};
+
+    while ( fs.size()/3 < nfaces)
+    {
+        std::unordered_map<uint64_t, int> mids;
+        const auto midpoint = [&]( int a, int b)
+        {
+            const uint64_t key = (uint64_t( std::min(a,b)) << 32) | uint64_t( std::max(a,b));
+            const auto it = mids.find(key);
+            if ( it != mids.end())
+                return it->second;
+            vs.push_back( (vs[a] + vs[b]).normalized());
+            return mids[key] = int(vs.size()) - 1;
+        };
+        std::vector<int> nfs;
+        nfs.reserve( 4*fs.size());
+        for ( size_t i = 0; i < fs.size(); i += 3)
+        {
+            const int a = fs[i];
+            const int b = fs[i+1];
+            const int c = fs[i+2];
+            const int ab = midpoint( a, b);
+            const int bc = midpoint( b, c);
+            const int ca = midpoint( c, a);
+            nfs.insert( nfs.end(), { a,ab,ca, b,bc,ab, c,ca,bc, ab,bc,ca});
+        }   // end for
+        fs.swap( nfs);
+    }   // end while
+
+    r3d::Mesh::Ptr mesh = r3d::Mesh::create();
+    for ( const r3d::Vec3f &v : vs)
+        mesh->addVertex( v[0], v[1], v[2]);
+    for ( size_t i = 0; i < fs.size(); i += 3)
+        mesh->addFace( fs[i], fs[i+1], fs[i+2]);
+    return mesh;
+}   // end makeIcosphere
+
+
+// A checkerboard texture image.
+cv::Mat makeTextureImage( int dim)
+{
+    cv::Mat_<cv::Vec3b> img( dim, dim);
+    for ( int i = 0; i < dim; ++i)
+        for ( int j = 0; j < dim; ++j)
+            img(i,j) = ((i/32 + j/32) % 2) ? cv::Vec3b( 230, 200, 160) : cv::Vec3b( 60, 90, 120);
+    return img;
+}   // end makeTextureImage
+
+
+// Add a single texture material to the mesh mapping spherical coordinates (if spherical)
+// or the XY plane over [-1,1]^2 (if not) to texture coordinates.
+void addTexture( r3d::Mesh &mesh, bool spherical)
+{
+    const int MID = mesh.addMaterial( makeTextureImage( TEXTURE_SIZE));
+    const auto uv = [&]( int vid)
+    {
+        const r3d::Vec3f &v = mesh.uvtx(vid);
+        if ( spherical)
+        {
+            const double lat = asin( std::max( -1.0f, std::min( 1.0f, v[1])));
+            return r3d::Vec2f( float( atan2( v[2], v[0]) / (2*PI) + 0.5), float( lat / PI + 0.5));
+        }   // end if
+        return r3d::Vec2f( (v[0] + 1.0f) / 2, (v[1] + 1.0f) / 2);
+    };
+    const int nf = int(mesh.numFaces());
+    for ( int fid = 0; fid < nf; ++fid)
+    {
+        const int *fvidxs = mesh.fvidxs(fid);
+        mesh.setOrderedFaceUVs( MID, fid, uv(fvidxs[0]), uv(fvidxs[1]), uv(fvidxs[2]));
+    }   // end for
+}   // end addTexture
+
+
+// Points on a side x side lattice over the middle 80% of the given image size.
+std::vector<cv::Point> makeLattice( const cv::Size &sz, int side)
+{
+    std::vector<cv::Point> pts;
+    pts.reserve( side*side);
+    for ( int i = 0; i < side; ++i)
+        for ( int j = 0; j < side; ++j)
+            pts.push_back( cv::Point( int(sz.width * (0.1 + 0.8*(j + 0.5)/side)), int(sz.height * (0.1 + 0.8*(i + 0.5)/side))));
+    return pts;
+}   // end makeLattice
+
+
+r3d::CameraParams makeCamera( float angle)
+{
+    const r3d::Vec3f pos( 4.0f * sinf(angle), 0.0f, 4.0f * cosf(angle));
+    return r3d::CameraParams( pos, r3d::Vec3f::Zero(), r3d::Vec3f( 0, 1, 0), 35);
+}   // end makeCamera
+
+
+void benchActors( const r3d::Mesh &mesh, const std::string &shape, bool tx, int repeats)
+{
+    const size_t nf = mesh.numFaces();
+    bench( "VtkActorCreator", "generateActor", shape, nf, tx,
+            [&](){ r3dvis::VtkActorCreator::generateActor( mesh);}, repeats);
+    bench( "VtkActorCreator", "generateSurfaceActor", shape, nf, tx,
+            [&](){ r3dvis::VtkActorCreator::generateSurfaceActor( mesh);}, repeats);
+    bench( "VtkActorCreator", "generatePointsActor", shape, nf, tx,
+            [&](){ r3dvis::VtkActorCreator::generatePointsActor( mesh);}, repeats);
+
+    const vtkSmartPointer<vtkActor> actor = r3dvis::VtkActorCreator::generateActor( mesh);
+    bench( "VtkTools", "makeMesh", shape, nf, tx, [&](){ r3dvis::makeMesh( actor);}, repeats);
+}   // end benchActors
+
+
+void benchSurfaceMapper( const r3d::Mesh &mesh, const std::string &shape, bool tx, int repeats)
+{
+    const size_t nf = mesh.numFaces();
+    const int nv = int(mesh.numVtxs());
+
+    // A 3-vector per vertex metric: the vertex positions themselves.
+    const r3dvis::MetricFn efn = [&mesh]( int vid, size_t k){ return mesh.uvtx(vid)[k];};
+    const r3dvis::BatchMetricFn bfn = [&mesh]( int id0, int n, float *out)
+    {
+        for ( int i = 0; i < n; ++i, out += 3)
+        {
+            const r3d::Vec3f &v = mesh.uvtx(id0+i);
+            out[0] = v[0];
+            out[1] = v[1];
+            out[2] = v[2];
+        }   // end for
+    };
+
+    const r3dvis::VertexSurfaceMapper emapper( efn, 3);
+    const r3dvis::VertexSurfaceMapper bmapper( bfn, 3);
+    r3dvis::VertexSurfaceMapper pmapper( bfn, 3);
+    pmapper.setNumThreads(0);
+    const Timing et = bench( "VertexSurfaceMapper", "makeArray MetricFn", shape, nf, tx,
+            [&](){ emapper.makeArray( mesh, "bench");}, repeats);
+    bench( "VertexSurfaceMapper", "makeArray BatchMetricFn", shape, nf, tx,
+            [&](){ bmapper.makeArray( mesh, "bench");}, repeats, et.bestMs);
+    bench( "VertexSurfaceMapper", "makeArray parallel", shape, nf, tx,
+            [&](){ pmapper.makeArray( mesh, "bench");}, repeats, et.bestMs);
+
+    // Incremental update of 1% of the vertices.
+    vtkSmartPointer<vtkFloatArray> arr = bmapper.makeArray( mesh, "bench");
+    IntSet cids;
+    for ( int vid = 0; vid < nv; vid += 100)
+        cids.insert(vid);
+    bench( "VertexSurfaceMapper", "update 1% of vertices", shape, nf, tx,
+            [&](){ bmapper.update( mesh, arr, cids);}, repeats);
+
+    // Scalar per face metric.
+    const r3dvis::BatchMetricFn bfFn = []( int id0, int n, float *out)
+    {
+        for ( int i = 0; i < n; ++i)
+            out[i] = sqrtf(float(id0 + i));
+    };
+    const r3dvis::FaceSurfaceMapper bfmapper( bfFn, 1);
+    bench( "FaceSurfaceMapper", "makeArray BatchMetricFn", shape, nf, tx,
+            [&](){ bfmapper.makeArray( mesh, "bench");}, repeats);
+}   // end benchSurfaceMapper
+
+
+void benchSnapshots( const r3d::Mesh &mesh, const std::string &shape, bool tx, int repeats)
+{
+    const size_t nf = mesh.numFaces();
+    r3dvis::OffscreenMeshViewer viewer( VIEWER_SIZE, 4);
+    vtkSmartPointer<vtkActor> actor;
+
+    // First frame after setting the actor includes uploading the geometry and texture. Each
+    // repeat gets a new actor (made and the old one released outside the timed region) since
+    // reusing one would reuse its already uploaded buffers.
+    benchEach( "OffscreenMeshViewer", "setActor+snapshot", shape, nf, tx,
+            [&](){ viewer.clear(); actor = r3dvis::VtkActorCreator::generateActor( mesh);},
+            [&](){ viewer.setActor( actor); viewer.snapshot();}, repeats);
+
+    // Changing the camera each time forces a render.
+    int k = 0;
+    bench( "OffscreenMeshViewer", "snapshot", shape, nf, tx,
+            [&](){ viewer.setCamera( makeCamera( 0.1f * (++k % 8))); viewer.snapshot();}, repeats);
+    bench( "OffscreenMeshViewer", "gbuffer", shape, nf, tx,
+            [&](){ viewer.setCamera( makeCamera( 0.1f * (++k % 8))); viewer.gbuffer();}, repeats);
+}   // end benchSnapshots
+
+
+void benchPicking( const r3d::Mesh &mesh, const std::string &shape, bool tx, int repeats)
+{
+    const size_t nf = mesh.numFaces();
+    r3dvis::Viewer::Ptr viewer = r3dvis::Viewer::create( true);
+    viewer->setSize( VIEWER_SIZE.width, VIEWER_SIZE.height);
+    const vtkSmartPointer<vtkActor> actor = r3dvis::VtkActorCreator::generateActor( mesh);
+    viewer->addActor( actor);
+    viewer->setCamera( makeCamera( 0.3f));
+    viewer->updateRender();
+
+    r3dvis::RendererPicker picker( viewer->renderer(), r3dvis::RendererPicker::TOP_LEFT);
+    const std::vector<cv::Point> spts = makeLattice( VIEWER_SIZE, int( sqrt( double(NUM_PICKS))));
+    const std::vector<cv::Point> bpts = makeLattice( VIEWER_SIZE, BATCH_SIDE);
+    const std::string nstr = std::to_string( spts.size());
+    const std::string bstr = std::to_string( bpts.size());
+
+    bench( "RendererPicker", "pickActor x" + nstr, shape, nf, tx,
+            [&](){ for ( const cv::Point &p : spts) picker.pickActor( p);}, repeats);
+    bench( "RendererPicker", "pickPosition x" + nstr, shape, nf, tx,
+            [&](){ for ( const cv::Point &p : spts) picker.pickPosition( p);}, repeats);
+
+    // The first pick on an actor builds its cell locator.
+    r3d::Vec3f v;
+    bench( "RendererPicker", "pickPosition(actor) locator build", shape, nf, tx,
+            [&](){ picker.clearLocators(); picker.pickPosition( actor, spts[0], v);}, 1);
+    bench( "RendererPicker", "pickPosition(actor) x" + nstr, shape, nf, tx,
+            [&](){ for ( const cv::Point &p : spts) picker.pickPosition( actor, p, v);}, repeats);
+
+    viewer->updateRender();     // Restore the frame buffer after selection passes
+    std::vector<r3d::Vec3f> vs;
+    std::vector<bool> hits;
+    bench( "RendererPicker", "pickPositions x" + bstr, shape, nf, tx,
+            [&](){ picker.pickPositions( bpts, vs, hits);}, repeats);
+
+    std::vector<r3d::Vec3f> wpts( mesh.numVtxs());
+    for ( size_t i = 0; i < wpts.size(); ++i)
+        wpts[i] = mesh.uvtx(int(i));
+    std::vector<cv::Point> ppts;
+    std::vector<bool> occluded;
+    bench( "RendererPicker", "projectToImagePlane all vertices occluded", shape, nf, tx,
+            [&](){ picker.projectToImagePlane( wpts, ppts, &occluded);}, repeats);
+
+    r3dvis::MeshBVH::Ptr bvh;
+    bench( "MeshBVH", "create", shape, nf, tx, [&](){ bvh = r3dvis::MeshBVH::create( mesh);}, repeats);
+    bvh->setTransform( r3dvis::toEigen( actor->GetMatrix()));
+    std::vector<r3dvis::MeshBVH::Hit> bhits;
+    bench( "RendererPicker", "pickFaces x" + bstr, shape, nf, tx,
+            [&](){ picker.pickFaces( *bvh, bpts, bhits);}, repeats);
+}   // end benchPicking
+
+
+void benchTextures( int repeats)
+{
+    for ( int dim : {512, 2048, 4096})
+    {
+        const cv::Mat img = makeTextureImage( dim);
+        bench( "VtkTools", "convertToTexture " + std::to_string(dim) + "^2", "image", 0, true,
+                [&](){ r3dvis::convertToTexture( img);}, repeats);
+    }   // end for
+}   // end benchTextures
+
+
+bool writeJSON( const std::string &fname, int repeats, bool software)
+{
+    std::ofstream ofs( fname);
+    if ( !ofs.is_open())
+        return false;
+    ofs << "{\n  \"repeats\": " << repeats << ",\n  \"software_rendering\": " << (software ? "true" : "false")
+        << ",\n  \"results\": [";
+    ofs << std::fixed << std::setprecision(4);
+    for ( size_t i = 0; i < results.size(); ++i)
+    {
+        const Result &r = results[i];
+        ofs << (i > 0 ? "," : "") << "\n    {\"group\": \"" << r.group << "\", \"name\": \"" << r.name
+            << "\", \"shape\": \"" << r.shape << "\", \"faces\": " << r.faces
+            << ", \"textured\": " << (r.textured ? "true" : "false")
+            << ", \"best_ms\": " << r.bestMs << ", \"median_ms\": " << r.medianMs << "}";
+    }   // end for
+    ofs << "\n  ]\n}\n";
+    return true;
+}   // end writeJSON
+
+
+bool writeCSV( const std::string &fname)
+{
+    std::ofstream ofs( fname);
+    if ( !ofs.is_open())
+        return false;
+    ofs << "group,name,shape,faces,textured,best_ms,median_ms\n" << std::fixed << std::setprecision(4);
+    for ( const Result &r : results)
+        ofs << r.group << "," << r.name << "," << r.shape << "," << r.faces << "," << int(r.textured)
+            << "," << r.bestMs << "," << r.medianMs << "\n";
+    return true;
+}   // end writeCSV
+
+
+void useSoftwareRendering()
+{
+#ifdef _WIN32
+    _putenv_s( "LIBGL_ALWAYS_SOFTWARE", "1");
+#else
+    setenv( "LIBGL_ALWAYS_SOFTWARE", "1", 0);
+#endif
+}   // end useSoftwareRendering
+
+
+int usage( const char *prog)
+{
+    std::cerr << "Usage: " << prog << " [--max-faces N=10000000] [--repeats R=3] [--json file] [--csv file] [--hardware]" << std::endl;
+    return EXIT_FAILURE;
+}   // end usage
+
+}   // end namespace
+
+
+int main( int argc, char **argv)
+{
+    size_t maxFaces = 10000000;
+    int repeats = 3;
+    std::string jsonFile, csvFile;
+    bool software = true;
+    for ( int i = 1; i < argc; ++i)
+    {
+        const bool hasVal = i+1 < argc;
+        if ( strcmp( argv[i], "--max-faces") == 0 && hasVal)
+            maxFaces = size_t( atoll( argv[++i]));
+        else if ( strcmp( argv[i], "--repeats") == 0 && hasVal)
+            repeats = atoi( argv[++i]);
+        else if ( strcmp( argv[i], "--json") == 0 && hasVal)
+            jsonFile = argv[++i];
+        else if ( strcmp( argv[i], "--csv") == 0 && hasVal)
+            csvFile = argv[++i];
+        else if ( strcmp( argv[i], "--hardware") == 0)
+            software = false;
+        else
+            return usage( argv[0]);
+    }   // end for
+    if ( repeats < 1)
+        return usage( argv[0]);
+
+    if ( software)
+        useSoftwareRendering();
+
+    std::cout << "Textures:" << std::endl;
+    benchTextures( repeats);
+
+    for ( size_t nfaces : FACE_COUNTS)
+    {
+        if ( nfaces > maxFaces)
+            break;
+        for ( const std::string shape : {"icosphere", "grid"})
+        {
+            const r3d::Mesh::Ptr mesh = shape == "grid" ? makeGridFaces( nfaces) : makeIcosphere( nfaces);
+            for ( bool tx : {false, true})
+            {
+                if ( tx)
+                    addTexture( *mesh, shape == "icosphere");
+                std::cout << shape << ": " << mesh->numVtxs() << " vertices, " << mesh->numFaces() << " faces"
+                          << (tx ? ", textured" : "") << std::endl;
+                benchActors( *mesh, shape, tx, repeats);
+                benchSurfaceMapper( *mesh, shape, tx, repeats);
+                benchSnapshots( *mesh, shape, tx, repeats);
+                benchPicking( *mesh, shape, tx, repeats);
+            }   // end for
+        }   // end for
+    }   // end for
+
+    if ( !jsonFile.empty() && !writeJSON( jsonFile, repeats, software))
+    {
+        std::cerr << "[ERROR] r3dvis_bench: Unable to write " << jsonFile << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+    if ( !csvFile.empty() && !writeCSV( csvFile))
+    {
+        std::cerr << "[ERROR] r3dvis_bench: Unable to write " << csvFile << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+    return EXIT_SUCCESS;
+}   // end main
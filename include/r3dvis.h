@@ -18,17 +18,30 @@
 #ifndef R3DVIS_H
 #define R3DVIS_H
 
+#include "r3dvis/ActorPickContext.h"
 #include "r3dvis/Axes.h"
+#include "r3dvis/ColourMaps.h"
+#include "r3dvis/ColourMapper.h"
 #include "r3dvis/KeyPresser.h"
 #include "r3dvis/LookupTable.h"
+#include "r3dvis/MemoryFootprint.h"
+#include "r3dvis/MeshBVH.h"
 #include "r3dvis/OffscreenMeshViewer.h"
+#include "r3dvis/OffscreenMeshViewerPool.h"
+#include "r3dvis/RangeEstimator.h"
+#include "r3dvis/RenderStats.h"
 #include "r3dvis/RendererPicker.h"
+#ifndef _WIN32
+#include "r3dvis/RenderFarm.h"
+#endif
 #include "r3dvis/ScalarLegend.h"
 #include "r3dvis/SurfaceMapper.h"
+#include "r3dvis/SurfaceMapperSet.h"
 #include "r3dvis/Viewer.h"
 #include "r3dvis/ViewerProjector.h"
 #include "r3dvis/VtkActorCreator.h"
 #include "r3dvis/VtkScalingActor.h"
+#include "r3dvis/VtkScalingActorSet.h"
 #include "r3dvis/VtkTools.h"
 #include "r3dvis/VtkVectorField.h"
 #include "r3dvis/VTKTypes.h"
@@ -0,0 +1,72 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_ActorPickContext_H
+#define r3dvis_ActorPickContext_H
+
+/**
+ * Picks actors from a fixed set of candidate props. Unlike RendererPicker::pickActor
+ * (which is given the candidates on every call) the candidates are kept in the prop
+ * picker's pick list between calls, and many points can be picked together from a single
+ * ID buffer render. As with a prop picker's pick list, props that aren't candidates
+ * don't occlude the candidates. No props are modified (e.g. hidden) when picking so
+ * picking doesn't dirty the scene.
+ */
+
+#include "RendererPicker.h"
+#include <vtkNew.h>
+#include <unordered_set>
+
+namespace r3dvis {
+
+class r3dvis_EXPORT ActorPickContext
+{
+public:
+    using PointOrigin = RendererPicker::PointOrigin;
+
+    ActorPickContext( vtkRenderer*, const std::vector<const vtkProp*>&,
+                      PointOrigin po=RendererPicker::BOTTOM_LEFT);
+
+    // Change the candidate set.
+    void add( const vtkProp*);
+    void remove( const vtkProp*);
+    void clear();
+    size_t size() const { return _cset.size();}
+
+    // Pick a single point using the prop picker. Returns null if no candidate is found.
+    const vtkActor* pickActor( const cv::Point&) const;
+    const vtkActor* pickActor( const cv::Point2f&) const;
+
+    // Pick many points with a single ID buffer render. On return, actors is the same
+    // length as the given points with null entries where no candidate actor was found.
+    // Returns the number of points that hit a candidate.
+    size_t pickActors( const std::vector<cv::Point>&, std::vector<const vtkActor*> &actors) const;
+    size_t pickActors( const std::vector<cv::Point2f>&, std::vector<const vtkActor*> &actors) const;
+
+private:
+    vtkRenderer *_ren;
+    const PointOrigin _pointOrigin;
+    std::unordered_set<const vtkProp*> _cset;
+    vtkNew<vtkPropPicker> _ppicker;
+
+    ActorPickContext( const ActorPickContext&) = delete;
+    void operator=( const ActorPickContext&) = delete;
+};  // end class
+
+}   // end namespace
+
+#endif
@@ -0,0 +1,95 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_COLOUR_MAPPER_H
+#define r3dvis_COLOUR_MAPPER_H
+
+/**
+ * Maps scalar values to RGBA8 colours using the colours of a LookupTable on the CPU.
+ * The colours are set on actors as direct scalars so changing the colouring doesn't go
+ * through the VTK mapper's scalar mapping (and its colour texture map) at all.
+ */
+
+#include "LookupTable.h"
+#include <vtkUnsignedCharArray.h>
+#include <vtkFloatArray.h>
+#include <vtkActor.h>
+#include <cstdint>
+
+namespace r3dvis {
+
+class r3dvis_EXPORT ColourMapper
+{
+public:
+    enum Mode
+    {
+        LINEAR, // Values mapped linearly over the range
+        BANDED, // As linear but quantised into a number of flat colour bands
+        LOG     // Log of values mapped linearly over the log of the range (values <= 0 are below range)
+    };  // end enum
+
+    // Name of the colour arrays set on actors.
+    static const char *ARRAY_NAME;
+
+    ColourMapper( const LookupTable&, float minv=0, float maxv=1, Mode m=LINEAR);
+
+    void setLookupTable( const LookupTable&);
+
+    void setRange( float minv, float maxv);
+    float minValue() const { return _minv;}
+    float maxValue() const { return _maxv;}
+
+    void setMode( Mode m) { _mode = m;}
+    Mode mode() const { return _mode;}
+
+    // Number of colour bands for BANDED mode (default 10).
+    void setNumBands( int n) { _nbands = std::max( n, 1);}
+    int numBands() const { return _nbands;}
+
+    // Colours (RGBA) for NaN values and values below and above the range. Values out of
+    // range take the first and last table colours unless these colours are set.
+    void setNaNColour( const cv::Vec4b &c) { _nanCol = _pack(c);}
+    void setBelowColour( const cv::Vec4b &c) { _belowCol = _pack(c); _useBelow = true;}
+    void setAboveColour( const cv::Vec4b &c) { _aboveCol = _pack(c); _useAbove = true;}
+    void clearOutOfRangeColours() { _useBelow = _useAbove = false;}
+
+    // Map n values (separated by stride floats) to n RGBA colours written to rgba.
+    void map( const float *vals, size_t n, uint8_t *rgba, size_t stride=1) const;
+
+    // Make a four component colour array from component k of the given array.
+    vtkSmartPointer<vtkUnsignedCharArray> map( const vtkFloatArray*, int k=0) const;
+
+    // Colour the actor from component k of the given array of point (or cell) values. The colours
+    // are set as the active point (or cell) scalars and the actor's mapper set to use them directly.
+    // If the actor already has a colour array of the right size from this function, it's updated
+    // in place and marked as modified.
+    void apply( vtkActor*, const vtkFloatArray*, bool cellData=false, int k=0) const;
+
+private:
+    std::vector<uint32_t> _cols;
+    float _minv, _maxv;
+    Mode _mode;
+    int _nbands;
+    uint32_t _nanCol, _belowCol, _aboveCol;
+    bool _useBelow, _useAbove;
+
+    static uint32_t _pack( const cv::Vec4b&);
+};  // end class
+
+}   // end namespace
+
+#endif
@@ -0,0 +1,55 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_COLOUR_MAPS_H
+#define r3dvis_COLOUR_MAPS_H
+
+/**
+ * Built in perceptually uniform colour maps as the 256 entry RGB reference tables.
+ * Use with LookupTable (which can resample them to any number of colours) or get a
+ * vtkLookupTable copied from a cached one with LookupTable::cachedCopyVTK.
+ */
+
+#include "r3dvis_Export.h"
+#include <cstdint>
+#include <string>
+
+namespace r3dvis {
+
+enum class ColourMap
+{
+    VIRIDIS,    // Sequential dark blue -> green -> yellow
+    MAGMA,      // Sequential black -> purple -> orange -> light yellow
+    CIVIDIS,    // Sequential dark blue -> grey -> yellow (colour vision deficiency friendly)
+    COOLWARM    // Diverging blue -> light grey -> red
+};  // end enum
+
+// Number of colour maps in the enum above.
+constexpr int NUM_COLOUR_MAPS = 4;
+
+// Entries in each colour map table.
+constexpr int COLOUR_MAP_SIZE = 256;
+
+// Return the table for the given map as COLOUR_MAP_SIZE consecutive RGB byte triples.
+r3dvis_EXPORT const uint8_t* colourMapTable( ColourMap);
+
+// Return the name of the given colour map (e.g. "viridis").
+r3dvis_EXPORT std::string colourMapName( ColourMap);
+
+}   // end namespace
+
+#endif
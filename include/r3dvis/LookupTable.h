@@ -19,6 +19,7 @@
 #define r3dvis_LOOKUP_TABLE_H
 
 #include "r3dvis_Export.h"
+#include "ColourMaps.h"
 #include <rimg/Colour.h>
 #include <opencv2/opencv.hpp>
 #include <vtkSmartPointer.h>
@@ -27,6 +28,9 @@
 
 namespace r3dvis {
 
+struct Quantization;
+class RangeEstimator;
+
 class r3dvis_EXPORT LookupTable
 {
 public:
@@ -40,6 +44,9 @@ public:
                  const rimg::Colour &midCol,
                  const rimg::Colour &maxCol, size_t ncols);
 
+    // Range of ncols sampled evenly from one of the built in colour maps.
+    explicit LookupTable( ColourMap, size_t ncols=COLOUR_MAP_SIZE);
+
     // Return the colour at the given index.
     const rimg::Colour &colour( int idx) const;
 
@@ -64,8 +71,30 @@ public:
                      const cv::Vec3b& maxCol,
                      size_t ncols);
 
+    // Sample ncols evenly from the given built in colour map.
+    void setColours( ColourMap, size_t ncols=COLOUR_MAP_SIZE);
+
     vtkSmartPointer<vtkLookupTable> toVTK() const;
 
+    // Return a histogram equalised version of this table for values distributed as given by the
+    // estimator. The returned table has ncols colours evenly spaced over [lo,hi] (so use [lo,hi]
+    // as the mapper's scalar range) where colour j is taken from this table at the fraction of
+    // the values in [lo,hi] that are less than the value at j. Use for example the 2nd and 98th
+    // percentiles as lo and hi for heavy tailed data.
+    LookupTable equalised( const RangeEstimator&, float lo, float hi, size_t ncols=COLOUR_MAP_SIZE) const;
+
+    // Return a VTK lookup table for the given colour map and number of colours. The colours
+    // are built on first request and cached, and each call returns a new table copied from the
+    // cache. Callers must get their own table since mappers push their scalar range into the
+    // table they're given (unless UseLookupTableScalarRangeOn) so a single shared table would
+    // take whichever range was rendered last. Thread safe.
+    static vtkSmartPointer<vtkLookupTable> cachedCopyVTK( ColourMap, size_t ncols=COLOUR_MAP_SIZE);
+
+    // Make a VTK lookup table for scalars quantised using the given quantisation
+    // (see SurfaceMapper::makeQuantizedArray) with its range set to the value levels.
+    // Non finite values (the quantisation's NaN level) are shown in the given RGB colour.
+    vtkSmartPointer<vtkLookupTable> toVTK( const Quantization&, const cv::Vec3b &nanCol=cv::Vec3b(128,128,128)) const;
+
 private:
     std::vector<rimg::Colour> _cols;
 };  // end class
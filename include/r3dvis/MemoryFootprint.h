@@ -0,0 +1,91 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_MEMORY_FOOTPRINT_H
+#define r3dvis_MEMORY_FOOTPRINT_H
+
+/**
+ * Accounting of the host memory used by actors, broken down by category. Sizes come
+ * from VTK's GetActualMemorySize on the mapper input data and its arrays, plus the sizes
+ * of texture images. Objects shared between actors (e.g. a texture or a data array used
+ * by several actors) are only counted once within a MemoryAccountant. GPU side copies of
+ * the data made by mappers on rendering aren't included.
+ */
+
+#include "r3dvis_Export.h"
+#include <vtkRenderer.h>
+#include <vtkActor.h>
+#include <unordered_set>
+#include <ostream>
+
+namespace r3dvis {
+
+struct r3dvis_EXPORT MemoryFootprint
+{
+    MemoryFootprint();
+
+    // Bytes by category.
+    size_t points;          // Point coordinates
+    size_t connectivity;    // Vertex, line, polygon and strip cell arrays
+    size_t pointData;       // Point data arrays (normals, texture coordinates, scalars etc)
+    size_t cellData;        // Cell data arrays
+    size_t fieldData;       // Field data arrays (e.g. the point to vertex map)
+    size_t textures;        // Texture images
+    size_t other;           // Anything else in the data sets (e.g. cell links built for picking)
+
+    size_t total() const;
+
+    // Counts over the data sets visited.
+    size_t numActors;
+    size_t numPoints;
+    size_t numCells;
+    size_t numVertices;     // Distinct mesh vertices referenced by point to vertex maps (if present)
+
+    MemoryFootprint &operator+=( const MemoryFootprint&);
+};  // end struct
+
+r3dvis_EXPORT std::ostream &operator<<( std::ostream&, const MemoryFootprint&);
+
+
+class r3dvis_EXPORT MemoryAccountant
+{
+public:
+    // Add the memory of the given actor or of all the actors in the given
+    // renderer to the footprint. Objects already counted are skipped.
+    void add( const vtkActor*);
+    void add( vtkRenderer*);
+
+    const MemoryFootprint &footprint() const { return _fp;}
+
+    void reset();
+
+private:
+    MemoryFootprint _fp;
+    std::unordered_set<const vtkObjectBase*> _seen;
+    bool _first( const vtkObjectBase*);
+    void _addDataSet( vtkDataSet*);
+    void _addTexture( vtkTexture*);
+};  // end class
+
+
+// Convenience functions for a single actor or all actors of a renderer.
+r3dvis_EXPORT MemoryFootprint memoryFootprint( const vtkActor*);
+r3dvis_EXPORT MemoryFootprint memoryFootprint( vtkRenderer*);
+
+}   // end namespace
+
+#endif
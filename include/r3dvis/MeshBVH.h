@@ -0,0 +1,103 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_MeshBVH_H
+#define r3dvis_MeshBVH_H
+
+/**
+ * Bounding volume hierarchy over the triangles of an r3d::Mesh for exact ray casting
+ * on the CPU without needing a rendering context. The hierarchy is built in parallel
+ * using binned SAH splits in the mesh's untransformed space, and leaves hold up to four
+ * triangles laid out so each ray is tested against all four at once using SIMD.
+ */
+
+#include "r3dvis_Export.h"
+#include <r3d/Mesh.h>
+#include <memory>
+#include <vector>
+
+namespace r3dvis {
+
+class r3dvis_EXPORT MeshBVH
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    using Ptr = std::shared_ptr<MeshBVH>;
+
+    struct Hit
+    {
+        Hit() : fid(-1), u(0), v(0), t(0), pos(r3d::Vec3f::Zero()) {}
+        int fid;        // ID of the face hit or -1 if no hit
+        float u, v;     // Barycentric weights of the second and third face vertices (fvidxs order)
+        float t;        // Distance along the ray to the hit in world units
+        r3d::Vec3f pos; // World position of the hit
+    };  // end struct
+
+    // Build over the faces of the given mesh (which must have sequential IDs) using up
+    // to nthreads threads (or all hardware threads if zero). The world transform is set
+    // from the mesh's transform matrix. The mesh isn't referenced after construction.
+    static Ptr create( const r3d::Mesh&, size_t nthreads=0);
+    explicit MeshBVH( const r3d::Mesh&, size_t nthreads=0);
+
+    // Set the transform from mesh space to world space (e.g. from an actor's matrix).
+    void setTransform( const r3d::Mat4f&);
+    const r3d::Mat4f &transform() const { return _T;}
+
+    size_t numFaces() const { return _nfaces;}
+    size_t numNodes() const { return _nodes.size();}
+
+    // Cast a ray given in world coordinates returning true with the nearest hit
+    // set if the ray hits the mesh at a distance of at least tmin along the ray.
+    bool intersect( const r3d::Vec3f &origin, const r3d::Vec3f &dir, Hit&, float tmin=0) const;
+
+    // Cast many rays in parallel using up to nthreads threads (all hardware threads if zero).
+    // On return, hits is the same size as origins and dirs. Returns the number of hits.
+    size_t intersect( const std::vector<r3d::Vec3f> &origins, const std::vector<r3d::Vec3f> &dirs,
+                      std::vector<Hit> &hits, size_t nthreads=0) const;
+
+    // Axis aligned node bounds. Internal nodes have count zero with their left child
+    // immediately following them and right child at index. Leaves index a Packet.
+    struct Node
+    {
+        float bmin[3];
+        float bmax[3];
+        int index;
+        int count;
+    };  // end struct
+
+    // Up to four triangles stored component-wise as a vertex and two edges.
+    // Unused slots have a face ID of -1 and zero edges so they're never hit.
+    struct Packet
+    {
+        float v0[3][4];
+        float e1[3][4];
+        float e2[3][4];
+        int fid[4];
+    };  // end struct
+
+private:
+    size_t _nfaces;
+    r3d::Mat4f _T, _iT;
+    std::vector<Node> _nodes;
+    std::vector<Packet> _packets;
+
+    bool _intersectModel( const Eigen::Vector3f &o, const Eigen::Vector3f &d, float tmin, float &tbest, int &fid, float &u, float &v) const;
+};  // end class
+
+}   // end namespace
+
+#endif
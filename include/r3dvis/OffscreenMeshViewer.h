@@ -27,6 +27,11 @@ namespace r3dvis {
 
 using byte = unsigned char;
 
+/**
+ * Rendering is deferred until a frame is actually needed (by a snapshot, extraction or
+ * picking function) so any sequence of changes to the model, size and camera followed by
+ * a snapshot renders only once. The camera clipping range is likewise only reset then.
+ */
 class r3dvis_EXPORT OffscreenMeshViewer
 {
 public:
@@ -48,10 +53,45 @@ public:
     void setBackgroundColour( double r, double g, double b);
     void setModelColour( double r, double g, double b);
 
+    // Render now if anything changed since the last render returning true iff rendered.
+    // Not normally needed since the functions below render as necessary.
+    bool render() const;
+
+    // Host memory used by the model's actor.
+    MemoryFootprint memoryFootprint() const { return _viewer->memoryFootprint();}
+
+    // Instrumentation of this viewer's public functions, its renders and its picker.
+    RenderStats &stats() const { return _viewer->stats();}
+
     // Take and return a snapshot of the scene.
     cv::Mat_<cv::Vec3b> snapshot() const;
+    // Take a snapshot straight into dst which must be continuous and the size of
+    // the viewer (e.g. a view onto a preallocated or shared buffer). Returns false
+    // with dst untouched if it isn't.
+    bool snapshot( cv::Mat_<cv::Vec3b> &dst) const;
     cv::Mat_<byte> lightnessSnapshot() const;
 
+    // Multiple per pixel attributes of the scene from a single render.
+    struct GBuffer
+    {
+        cv::Mat_<cv::Vec3b> bgr;        // Colour snapshot
+        cv::Mat_<cv::Vec3f> normals;    // Camera space unit surface normals (facing the camera)
+        cv::Mat_<cv::Vec3f> positions;  // World positions
+        cv::Mat_<float> depth;          // Linear depth from the camera along the view direction
+        cv::Mat_<byte> mask;            // 255 where any geometry is seen and 0 on the background
+    };  // end struct
+
+    // Render once and capture the colour snapshot alongside the normal, world position
+    // and depth maps of the scene. These come from the Z-buffer so cover everything rendered
+    // and not just the model. Background pixels are zero in all but the colour image. Use
+    // faceIds (which costs a selection render) to restrict them to the model's pixels.
+    // Normals are estimated from the differences of neighbouring camera space positions.
+    GBuffer gbuffer() const;
+
+    // Return the per pixel IDs of the model's visible faces (-1 for background) and,
+    // if not null, the matching map of prop indices into the given vector of props.
+    cv::Mat_<int> faceIds( cv::Mat_<int> *propIds=nullptr, std::vector<const vtkProp*> *props=nullptr) const;
+
     // The following picking operations all use the top left as the image plane origin.
 
     // Returns true if given point (with top left origin) intersects with the current model/actor.
@@ -60,14 +100,24 @@ public:
     // Return the projected world position of the point (use after pick).
     r3d::Vec3f worldPosition( const cv::Point2f&) const;
 
+    // Batch version of worldPosition using a single read of the Z-buffer (see RendererPicker::pickPositions).
+    // On return, hits[i] is false if point i is on the background. Returns the number of hits.
+    size_t worldPositions( const std::vector<cv::Point2f>&, std::vector<r3d::Vec3f>&, std::vector<bool> &hits) const;
+
     // The inverse operation which takes a position in space and maps it to the image plane.
     cv::Point2f imagePlane( const r3d::Vec3f&) const;
 
+    // Batch version of imagePlane. If occluded is not null, occluded[i] is set true
+    // if point i is hidden by the model or projects outside of the viewer.
+    void imagePlane( const std::vector<r3d::Vec3f>&, std::vector<cv::Point2f>&, std::vector<bool> *occluded=nullptr) const;
+
 private:
     vtkSmartPointer<vtkActor> _actor;
     Viewer::Ptr _viewer;
     mutable RendererPicker *_picker;
+    mutable bool _resetClipping;
     RendererPicker *picker() const;
+    void _resetClippingIfNeeded() const;
 
     OffscreenMeshViewer( const OffscreenMeshViewer&) = delete;
     void operator=( const OffscreenMeshViewer&) = delete;
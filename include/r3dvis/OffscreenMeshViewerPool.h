@@ -0,0 +1,100 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_OffscreenMeshViewerPool_H
+#define r3dvis_OffscreenMeshViewerPool_H
+
+/**
+ * A pool of worker threads each owning its own OffscreenMeshViewer (and so its
+ * own offscreen render window and context). Snapshot jobs are queued and handed
+ * to the next free worker. For headless machines, VTK should be built with an
+ * offscreen software backend (OSMesa) so that each worker gets an independent
+ * context that doesn't need a display or GPU.
+ */
+
+#include "OffscreenMeshViewer.h"
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <deque>
+
+namespace r3dvis {
+
+class r3dvis_EXPORT OffscreenMeshViewerPool
+{
+public:
+    using Ptr = std::shared_ptr<OffscreenMeshViewerPool>;
+    using Snapshots = std::vector<cv::Mat_<cv::Vec3b> >;
+
+    struct Options
+    {
+        Options();
+        cv::Size dims;          // Snapshot dimensions (default 512x512)
+        cv::Vec3d bgColour;     // Background colour (default black)
+        bool setModelColour;    // Set the model colour (only if true, otherwise VTK's default white)
+        cv::Vec3d modelColour;
+        bool reuseActor;        // Reuse the worker's actor if made for the same mesh (default true)
+    };  // end struct
+
+    // Create with the given number of worker threads. If zero, the number
+    // of worker threads is the number of hardware threads available.
+    static Ptr create( size_t nworkers=0);
+    explicit OffscreenMeshViewerPool( size_t nworkers=0);
+    ~OffscreenMeshViewerPool();  // Finishes all queued jobs before returning.
+
+    size_t size() const { return _workers.size();}
+
+    // Return the number of queued jobs not yet taken by a worker.
+    size_t pending() const;
+
+    // Queue a snapshot job for the given mesh taking one snapshot per camera.
+    // Snapshots are returned in the same order as the cameras. The mesh must
+    // not be modified until the returned future is ready. Workers reuse the
+    // actor they created for a mesh if their next job is for the same mesh
+    // object so meshes must not be edited in place between jobs unless the
+    // reuseActor option is set false. Exceptions thrown while taking the
+    // snapshots (including failure to create the actor) are rethrown from
+    // the future's get.
+    std::future<Snapshots> submit( const std::shared_ptr<const r3d::Mesh>&,
+                                   const std::vector<r3d::CameraParams>&,
+                                   const Options& opts=Options());
+
+    // Queue an arbitrary job to be run against a worker's viewer.
+    // Exceptions thrown by the job are rethrown from the future's get.
+    std::future<void> submit( const std::function<void( OffscreenMeshViewer&)>&);
+
+private:
+    // Jobs are given the worker's viewer and the mesh last set on it.
+    using Job = std::function<void( OffscreenMeshViewer&, std::weak_ptr<const r3d::Mesh>&)>;
+    std::vector<std::thread> _workers;
+    std::deque<Job> _jobs;
+    mutable std::mutex _lock;
+    std::condition_variable _cv;
+    bool _stopping;
+
+    void _enqueue( Job&&);
+    void _run();
+
+    OffscreenMeshViewerPool( const OffscreenMeshViewerPool&) = delete;
+    void operator=( const OffscreenMeshViewerPool&) = delete;
+};  // end class
+
+}   // end namespace
+
+#endif
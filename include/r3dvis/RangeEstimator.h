@@ -0,0 +1,82 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_RANGE_ESTIMATOR_H
+#define r3dvis_RANGE_ESTIMATOR_H
+
+/**
+ * Single pass estimation of the distribution of a stream of values: exact min/max and count,
+ * plus a fixed size histogram whose range doubles as needed to contain every value seen.
+ * Percentiles are interpolated from the histogram so are accurate to within a bin width
+ * (the range over the number of bins). Estimators over parts of the data can be merged,
+ * which is how the parallel estimate functions work. Non finite values are only counted.
+ */
+
+#include "SurfaceMapper.h"
+#include <vector>
+
+namespace r3dvis {
+
+class r3dvis_EXPORT RangeEstimator
+{
+public:
+    // The number of bins is rounded up to a power of two (at least 16).
+    explicit RangeEstimator( size_t nbins=4096);
+
+    void add( float v);
+    void add( const float *vals, size_t n, size_t stride=1);
+
+    // Merge in the values seen by another estimator.
+    void merge( const RangeEstimator&);
+
+    size_t count() const { return _count;}         // Number of finite values seen
+    size_t nonFinite() const { return _nonFinite;}  // Number of NaN or infinite values seen
+    float min() const { return _min;}
+    float max() const { return _max;}
+
+    // Estimate the value below which p percent (in [0,100]) of the values fall.
+    float percentile( double p) const;
+
+    // Fraction of values less than or equal to v (the empirical cumulative distribution).
+    double cdf( float v) const;
+
+    // Histogram of the values over nbins equal width bins spanning [lo,hi] resampled from the
+    // internal histogram. Values outside of the range are counted in the end bins.
+    std::vector<size_t> histogram( size_t nbins, float lo, float hi) const;
+
+    // Estimate from component k of the given array or from the metric function over the IDs [0,n)
+    // in parallel over up to nthreads threads (all hardware threads if zero). The metric function
+    // must be thread safe if more than one thread is used.
+    static RangeEstimator estimate( const vtkFloatArray*, int k=0, size_t nthreads=0, size_t nbins=4096);
+    static RangeEstimator estimate( const MetricFn&, int n, size_t k=0, size_t nthreads=0, size_t nbins=4096);
+
+private:
+    size_t _nbins;
+    std::vector<size_t> _bins;
+    double _lo, _width;         // Histogram range is [_lo, _lo + _nbins*_width)
+    size_t _count, _nonFinite;
+    float _min, _max;
+    std::vector<float> _pending;    // Values held until the initial range is known
+
+    void _init();
+    void _bin( float v, size_t c=1);
+    void _grow( double v);
+};  // end class
+
+}   // end namespace
+
+#endif
@@ -0,0 +1,137 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_RenderFarm_H
+#define r3dvis_RenderFarm_H
+
+/**
+ * Process based alternative to OffscreenMeshViewerPool (POSIX only).
+ * RenderFarm launches N r3dvis_render_worker processes, each owning a single
+ * OffscreenMeshViewer, and talks to them over Unix domain sockets. Meshes
+ * are passed to the workers in shared memory (see SharedMesh) and the workers
+ * read their snapshots' pixels directly into a shared memory block owned by the
+ * returned RenderResult. Workers that crash or don't reply within the timeout
+ * are restarted and their job retried once, so a bad VTK/OpenGL path can't take
+ * down (or hang) the client process.
+ */
+
+#include "r3dvis_Export.h"
+#include <r3d/Mesh.h>
+#include <r3d/CameraParams.h>
+#include <condition_variable>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <string>
+
+namespace r3dvis {
+
+class SharedMemory;
+
+
+// A copy of a mesh (vertices, faces, transform and a single optional texture)
+// in a named shared memory block that render workers map read only. Create once
+// and reuse for as many jobs as needed. The block is removed on destruction.
+class r3dvis_EXPORT SharedMesh
+{
+public:
+    using Ptr = std::shared_ptr<SharedMesh>;
+
+    // Returns null if the mesh doesn't have sequential IDs, has more than one
+    // material, or the shared memory block can't be created.
+    static Ptr create( const r3d::Mesh&);
+
+    const std::string& name() const;
+    size_t bytes() const;
+
+    // Recreate the mesh from the given shared memory block (worker side).
+    // The mesh's transform is returned separately in T. Returns null if the
+    // block is malformed (e.g. too small or with out of range face indices).
+    static r3d::Mesh::Ptr read( const void*, size_t bytes, r3d::Mat4f &T);
+
+private:
+    std::shared_ptr<SharedMemory> _shm;
+    SharedMesh() = default;
+};  // end class
+
+
+// The snapshots from a single job. The images are views onto shared memory
+// and remain valid for as long as any copy of this RenderResult exists.
+struct r3dvis_EXPORT RenderResult
+{
+    std::vector<cv::Mat_<cv::Vec3b> > images;   // Empty if the job failed
+    std::shared_ptr<SharedMemory> buffer;
+};  // end struct
+
+
+class r3dvis_EXPORT RenderFarm
+{
+public:
+    using Ptr = std::shared_ptr<RenderFarm>;
+
+    // Launch nworkers worker processes using the given worker executable
+    // (found on the PATH if not given as a path). If nworkers is zero, one
+    // worker per hardware thread is launched.
+    static Ptr create( size_t nworkers=0, const std::string &workerExe="r3dvis_render_worker");
+    RenderFarm( size_t nworkers=0, const std::string &workerExe="r3dvis_render_worker");
+    ~RenderFarm();  // Finishes queued jobs then shuts down the workers.
+
+    size_t size() const { return _workers.size();}
+
+    // Set the time in milliseconds a worker has to finish a job before it's
+    // considered hung and restarted (default 60000). Negative waits forever.
+    void setTimeout( int ms) { _timeoutMs = ms;}
+    int timeout() const { return _timeoutMs;}
+
+    // Queue a job rendering the mesh from each of the given cameras at the
+    // given size and with the given background colour. Jobs are taken by the
+    // next free worker. Workers keep the most recent mesh set on them so jobs
+    // using the same SharedMesh avoid rebuilding the actor.
+    std::future<RenderResult> render( const SharedMesh::Ptr&,
+                                      const std::vector<r3d::CameraParams>&,
+                                      const cv::Size&,
+                                      const cv::Vec3d &bg=cv::Vec3d(0,0,0));
+
+    // Worker process side: serve jobs on the given connected socket until it's
+    // closed by the client. Returns the process exit code.
+    static int serve( int fd);
+
+private:
+    struct Job;
+    struct Worker;
+    const std::string _exe;
+    std::atomic<int> _timeoutMs;
+    std::vector<std::unique_ptr<Worker> > _workers;
+    std::deque<std::shared_ptr<Job> > _jobs;
+    std::mutex _lock;
+    std::condition_variable _cv;
+    bool _stopping;
+
+    bool _spawn( Worker&);
+    void _kill( Worker&);
+    bool _runJob( Worker&, Job&);
+    void _dispatch( Worker&);
+
+    RenderFarm( const RenderFarm&) = delete;
+    void operator=( const RenderFarm&) = delete;
+};  // end class
+
+}   // end namespace
+
+#endif
@@ -0,0 +1,209 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_RENDER_STATS_H
+#define r3dvis_RENDER_STATS_H
+
+/**
+ * Instrumentation of rendering. A RenderRecord is written to every sink added to a RenderStats
+ * object for each instrumented call (renders, frame buffer extractions and picking operations).
+ * Calls made within other instrumented calls are recorded too so records nest (which shows
+ * nicely as a flame chart when loading the output of ChromeTraceSink into chrome://tracing or
+ * Perfetto). Nothing is timed or counted unless at least one sink has been added.
+ */
+
+#include "r3dvis_Export.h"
+#include <vtkRenderer.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+
+namespace r3dvis {
+
+struct r3dvis_EXPORT RenderRecord
+{
+    RenderRecord();
+    std::string label;      // Name of the instrumented call
+    size_t threadId;        // Small sequential ID of the calling thread
+    double startUs;         // Start of the call in microseconds since the first record
+    double wallMs;          // Wall time of the whole call
+    int numRenders;         // Number of renders within the call
+    double renderMs;        // Sum of the renderer's own render times for those renders
+    double captureMs;       // Time spent reading back / capturing frame buffers
+    size_t numTriangles;    // Triangles over the visible props at the end of the call
+    size_t numPoints;       // Points over the visible props at the end of the call
+    size_t textureBytes;    // Memory of the distinct textures of the visible props
+};  // end struct
+
+
+class r3dvis_EXPORT RenderSink
+{
+public:
+    using Ptr = std::shared_ptr<RenderSink>;
+    virtual ~RenderSink() {}
+    virtual void write( const RenderRecord&) = 0;
+};  // end class
+
+
+// Keep the most recent records in memory.
+class r3dvis_EXPORT RingBufferSink : public RenderSink
+{
+public:
+    explicit RingBufferSink( size_t capacity=1024);
+
+    void write( const RenderRecord&) override;
+
+    // Return the stored records from oldest to newest.
+    std::vector<RenderRecord> records() const;
+
+    size_t size() const;
+    size_t capacity() const { return _cap;}
+    void clear();
+
+private:
+    const size_t _cap;
+    size_t _next;
+    std::vector<RenderRecord> _recs;
+    mutable std::mutex _mtx;
+};  // end class
+
+
+// Write a row per record to a CSV file with a header row of the field names.
+class r3dvis_EXPORT CSVSink : public RenderSink
+{
+public:
+    explicit CSVSink( const std::string &fname);
+    bool isOpen() const { return _ofs.is_open();}
+    void write( const RenderRecord&) override;
+
+private:
+    std::ofstream _ofs;
+    std::mutex _mtx;
+};  // end class
+
+
+// Write records as complete ("X") events in the Chrome trace event JSON array format.
+// The array is closed when the sink is destroyed but viewers accept unterminated arrays.
+class r3dvis_EXPORT ChromeTraceSink : public RenderSink
+{
+public:
+    explicit ChromeTraceSink( const std::string &fname);
+    ~ChromeTraceSink() override;
+    bool isOpen() const { return _ofs.is_open();}
+    void write( const RenderRecord&) override;
+
+private:
+    std::ofstream _ofs;
+    bool _first;
+    std::mutex _mtx;
+};  // end class
+
+
+class r3dvis_EXPORT RenderStats
+{
+public:
+    RenderStats();
+
+    void addSink( const RenderSink::Ptr&);
+    void removeSink( const RenderSink::Ptr&);
+    void clearSinks();
+
+    // True iff there are sinks to write records to.
+    bool enabled() const { return !_sinks.empty();}
+
+    // Accumulate the time of a render or frame buffer capture for the records of enclosing calls.
+    void addRender( double ms) { _nrenders++; _renderMs += ms;}
+    void addCapture( double ms) { _captureMs += ms;}
+
+    // Write the record to all sinks.
+    void write( const RenderRecord&) const;
+
+    // Set the triangle, point and texture memory counts of the given record
+    // from the visible props of the given renderer.
+    static void sceneStats( vtkRenderer*, RenderRecord&);
+
+    // Microseconds since the first call to this function.
+    static double nowUs();
+
+private:
+    std::vector<RenderSink::Ptr> _sinks;
+    int _nrenders;
+    double _renderMs;
+    double _captureMs;
+    friend class RenderTimer;
+};  // end class
+
+
+// Scoped timing of an instrumented call writing its record to the stats on destruction.
+// Does nothing if stats is null or has no sinks. If a renderer is given, the scene
+// statistics of the record are set from it.
+class r3dvis_EXPORT RenderTimer
+{
+public:
+    RenderTimer( RenderStats*, const char *label, vtkRenderer *ren=nullptr);
+    ~RenderTimer();
+
+private:
+    RenderStats *_stats;
+    const char *_label;
+    vtkRenderer *_ren;
+    double _t0;
+    int _n0;
+    double _r0, _c0;
+
+    RenderTimer( const RenderTimer&) = delete;
+    void operator=( const RenderTimer&) = delete;
+};  // end class
+
+
+// Scoped timing of a frame buffer capture adding its time to the stats on destruction.
+class r3dvis_EXPORT CaptureTimer
+{
+public:
+    explicit CaptureTimer( RenderStats*);
+    ~CaptureTimer();
+
+private:
+    RenderStats *_stats;
+    double _t0;
+
+    CaptureTimer( const CaptureTimer&) = delete;
+    void operator=( const CaptureTimer&) = delete;
+};  // end class
+
+
+// Scoped timing of a hardware selection (e.g. prop picking or ID buffer capture). The
+// selection's render passes are counted as a single render of its duration on destruction.
+class r3dvis_EXPORT SelectionTimer
+{
+public:
+    explicit SelectionTimer( RenderStats*);
+    ~SelectionTimer();
+
+private:
+    RenderStats *_stats;
+    double _t0;
+
+    SelectionTimer( const SelectionTimer&) = delete;
+    void operator=( const SelectionTimer&) = delete;
+};  // end class
+
+}   // end namespace
+
+#endif
@@ -19,13 +19,28 @@
 #define r3dvis_RendererPicker_H
 
 #include "r3dvis_Export.h"
+#include "RenderStats.h"
+#include "MeshBVH.h"
 #include <r3d/r3dTypes.h>
+#include <vtkStaticCellLocator.h>
+#include <vtkPropPicker.h>
+#include <vtkCellPicker.h>
+#include <vtkWeakPointer.h>
 #include <vtkRenderer.h>
 #include <vtkActor.h>
+#include <unordered_map>
 #include <vector>
 
 namespace r3dvis {
 
+/**
+ * Picking and projection against a renderer. The picking functions are const but share
+ * the picker's internal VTK pickers and locator cache so a RendererPicker must not be
+ * used from more than one thread at a time (use one picker per thread instead).
+ * The hardware selection passes of pickActor, pickPosition (without a prop) and pickArea
+ * overwrite the frame buffer so these mark the renderer modified which makes a Viewer
+ * using it dirty (see Viewer::isDirty) and re-render before its pixels are next read.
+ */
 class r3dvis_EXPORT RendererPicker
 {
 public:
@@ -40,6 +55,10 @@ public:
     // Calls ResetCameraClippingRange() on the provided vtkRenderer to ensure picking accuracy.
     RendererPicker( vtkRenderer*, PointOrigin po=BOTTOM_LEFT, double tolerance=0.0005);
 
+    // Record the picking and projection functions to the given stats (not owned) if not null.
+    void setStats( RenderStats *stats) { _stats = stats;}
+    RenderStats *stats() const { return _stats;}
+
     // Given a 2D point, find the actor being pointed to. Returns null if no actor found.
     const vtkActor* pickActor( const cv::Point&) const;
     const vtkActor* pickActor( const cv::Point2f&) const;
@@ -52,6 +71,8 @@ public:
     // Returns true iff a valid intersection of the actor is found.
     // On (true) return, the provided Vec3f is set to the intersection point.
     // Slower but more accurate than the non-actor specific version below.
+    // A cell locator is cached for each actor picked from and is only rebuilt
+    // if the actor's poly data changes so repeated picks on the same actor are fast.
     bool pickPosition( const vtkProp*, const cv::Point&, r3d::Vec3f&) const;
     bool pickPosition( const vtkProp*, const cv::Point2f&, r3d::Vec3f&) const;
 
@@ -62,14 +83,80 @@ public:
     r3d::Vec3f pickPosition( const cv::Point&) const;
     r3d::Vec3f pickPosition( const cv::Point2f&) const;
 
+    // Batch version of the above for many points. Instead of picking, the Z-buffer from
+    // the most recent render is read once and all points are unprojected together through
+    // the inverse of the camera's composite projection matrix. On return, vs and hits are
+    // the same length as the given points with hits[i] false (and vs[i] zero) if point i
+    // is on the background or outside the viewport. Returns the number of hits.
+    size_t pickPositions( const std::vector<cv::Point>&, std::vector<r3d::Vec3f> &vs, std::vector<bool> &hits) const;
+    size_t pickPositions( const std::vector<cv::Point2f>&, std::vector<r3d::Vec3f> &vs, std::vector<bool> &hits) const;
+
     // Project v to the rendering image plane. Point is returned using
     // the coordinates origin set in the constructor.
     cv::Point projectToImagePlane( const r3d::Vec3f& v) const;
 
+    // Discard the cached cell locators. Locators for props deleted or removed from the
+    // renderer are discarded automatically when locators for new props are cached.
+    void clearLocators();
+
+    // Batch versions of projectToImagePlane. The camera's composite projection is taken once
+    // and all points are projected together. If occluded is not null, the projected points are
+    // also depth tested against the Z-buffer from the most recent render and occluded[i] is set
+    // true if point i is hidden behind rendered geometry or projects outside of the viewport.
+    // Points on or behind the camera plane are returned as (-1,-1) (and are occluded).
+    void projectToImagePlane( const std::vector<r3d::Vec3f>&, std::vector<cv::Point>&, std::vector<bool> *occluded=nullptr) const;
+    void projectToImagePlane( const r3d::MatX3f&, std::vector<cv::Point>&, std::vector<bool> *occluded=nullptr) const;
+
+    // Exact face picking by casting rays from the camera through the given points against
+    // the given BVH (whose transform should match the mesh actor's). Doesn't need a rendered
+    // frame and isn't limited by Z-buffer precision. Returns true iff the face was hit.
+    bool pickFace( const MeshBVH&, const cv::Point&, MeshBVH::Hit&) const;
+    bool pickFace( const MeshBVH&, const cv::Point2f&, MeshBVH::Hit&) const;
+
+    // Batch version of pickFace with the rays cast in parallel. On return, hits is the same
+    // length as the given points with a face ID of -1 for misses. Returns the number of hits.
+    size_t pickFaces( const MeshBVH&, const std::vector<cv::Point>&, std::vector<MeshBVH::Hit>&) const;
+    size_t pickFaces( const MeshBVH&, const std::vector<cv::Point2f>&, std::vector<MeshBVH::Hit>&) const;
+
+    // Area selection. Find the faces (and optionally vertices) of the given actor, which must have
+    // been generated from the given mesh, that are inside a rectangle or lasso polygon given using
+    // the point origin set in the constructor. If seeThrough is false, only faces visible inside the
+    // region are found from a single ID buffer render, and vertices are those of the visible faces
+    // that project into the region. If seeThrough is true, all vertices projecting into the region
+    // are found whether occluded or not, along with their faces and the visible faces.
+    // Returns the number of faces found (fids is cleared first) or zero if the mesh doesn't
+    // have sequential IDs.
+    size_t pickArea( const vtkActor*, const r3d::Mesh&, const cv::Rect&,
+                     IntSet &fids, IntSet *vids=nullptr, bool seeThrough=false) const;
+    size_t pickArea( const vtkActor*, const r3d::Mesh&, const std::vector<cv::Point> &lasso,
+                     IntSet &fids, IntSet *vids=nullptr, bool seeThrough=false) const;
+
+    // Point helpers shared with other pickers. Convert a point given as proportions of the
+    // viewport's width and height to pixels, test if a pixel is inside the viewport, and
+    // return a pixel given with the given origin using a bottom left origin as VTK expects.
+    static cv::Point toPixels( vtkRenderer*, const cv::Point2f&);
+    static bool isValidPoint( vtkRenderer*, const cv::Point&);
+    static cv::Point toBottomLeft( vtkRenderer*, const cv::Point&, PointOrigin);
+
 private:
     vtkRenderer* _ren;
     const PointOrigin _pointOrigin;
     const double _tolerance;
+    RenderStats *_stats;
+    vtkSmartPointer<vtkCellPicker> _cpicker;
+    vtkSmartPointer<vtkPropPicker> _ppicker;
+
+    struct CachedLocator
+    {
+        vtkWeakPointer<vtkProp> prop;         // Null once the prop is deleted
+        vtkSmartPointer<vtkPolyData> pdata;   // Data the locator was built from
+        vtkMTimeType mtime;                   // Modified time of pdata at build
+        vtkSmartPointer<vtkStaticCellLocator> locator;
+    };  // end struct
+    mutable std::unordered_map<const vtkProp*, CachedLocator> _locators;
+
+    void _updateLocator( const vtkProp*) const;
+    void _evictLocators() const;
 };  // end class
 
 }   // end namespace
@@ -23,7 +23,10 @@
 #include <vtkActor.h>
 #include <vtkSmartPointer.h>
 #include <vtkFloatArray.h>
+#include <vtkIntArray.h>
+#include <vtkMapper.h>
 #include <functional>
+#include <mutex>
 
 namespace r3dvis {
 
@@ -31,14 +34,48 @@ namespace r3dvis {
 // k (always 0 for scalars but up to 1 less than dimensionality for vector metrics).
 using MetricFn = std::function<float(int id, size_t k)>;
 
+// Get metrics in bulk for the n contiguous polygon or vertex IDs starting at id0. Values
+// must be written tuple-major into out so that out[i*dims + k] is component k of id0+i.
+using BatchMetricFn = std::function<void(int id0, int n, float *out)>;
+
+// Linear quantisation of metric values to integer levels for compact 8 or 16 bit arrays.
+// Value v is stored as level q = round((v - offset)/scale) clamped to [0, levels-2].
+// The top level (nanLevel) is reserved for non finite values so they aren't confused
+// with the minimum and can be given their own colour (see LookupTable::toVTK).
+struct r3dvis_EXPORT Quantization
+{
+    // Quantise the range [minv,maxv] over 2^bits - 1 levels (bits must be 8 or 16).
+    Quantization( float minv, float maxv, int bits=8);
+
+    float offset;
+    float scale;
+    int levels;
+
+    inline float value( int q) const { return offset + q*scale;}  // Not meaningful for nanLevel
+    int level( float v) const;
+    inline int nanLevel() const { return levels - 1;}
+
+    // Set the mapper to map the quantised scalars through its lookup table with the scalar
+    // range set to the value levels so colour mapping matches [minv,maxv]. The NaN level
+    // is above the range so gets the lookup table's above range colour if it uses one.
+    void apply( vtkMapper*) const;
+};  // end struct
+
+
 class r3dvis_EXPORT SurfaceMapper
 {
 public:
     // Set dims to 1 for mapping scalars (default), higher values for vectors.
     SurfaceMapper( const MetricFn&, size_t dims);
+    SurfaceMapper( const BatchMetricFn&, size_t dims);
 
     inline size_t dims() const { return _ndims;}
 
+    // Evaluate the metric function over ID ranges in parallel using up to n threads
+    // (all hardware threads if zero). Only use with thread safe metric functions! Default 1.
+    void setNumThreads( size_t n);
+    inline size_t numThreads() const { return _nthreads;}
+
     // Make and return the array of metrics - returned array's name is 'name'.
     // (Array name must be set before adding to an actor's cell or point data).
     // Use function makeArrayNoTx to assume the same number of vertices as the mesh
@@ -46,13 +83,55 @@ public:
     vtkSmartPointer<vtkFloatArray> makeArray( const r3d::Mesh&, const char *name) const;
     vtkSmartPointer<vtkFloatArray> makeArrayNoTx( const r3d::Mesh&, const char *name) const;
 
+    // Make the array for the given actor generated from the mesh. If the actor has a point to
+    // vertex map (see r3dvis::getPointVertexMap), vertex metrics are gathered through it in a
+    // single pass, otherwise this is the same as makeArrayNoTx.
+    vtkSmartPointer<vtkFloatArray> makeArray( const vtkActor*, const r3d::Mesh&, const char *name) const;
+
+    // As above but quantise the values into a vtkUnsignedCharArray (8 bit) or a
+    // vtkUnsignedShortArray (16 bit) depending on the number of quantisation levels.
+    // Use Quantization::apply on the actor's mapper to set up colour mapping.
+    vtkSmartPointer<vtkDataArray> makeQuantizedArray( const vtkActor*, const r3d::Mesh&,
+                                                      const Quantization&, const char *name) const;
+
+    // Recompute only the tuples of an array previously made by makeArray (or makeArrayNoTx)
+    // that correspond to the given face or vertex IDs, then mark the array as modified.
+    // Time taken is proportional to the number of changed IDs rather than the mesh size.
+    void update( const r3d::Mesh&, vtkFloatArray*, const IntSet &changedIds) const;
+    void updateNoTx( const r3d::Mesh&, vtkFloatArray*, const IntSet &changedIds) const;
+
+    // The number of metric tuples for the mesh (its number of faces or vertices).
+    inline int count( const r3d::Mesh &m) const { return _numIds(m);}
+
+    // Evaluate the metric for all faces or vertices of the mesh writing tuple-major into
+    // out which must have space for count(mesh)*dims() values. No fan out is done.
+    void evaluate( const r3d::Mesh &m, float *out) const { _eval( 0, _numIds(m), out);}
+
 protected:
-    const MetricFn _mfn;
+    const MetricFn _mfn;        // Empty if constructed with a BatchMetricFn
+    const BatchMetricFn _bfn;   // Empty if constructed with a MetricFn
+
+    // Write the metrics for IDs [id0, id0+n) tuple-major into out using whichever function was given.
+    void _eval( int id0, int n, float *out) const;
+
     virtual void _makeArray( const r3d::Mesh&, vtkFloatArray*) const = 0;
     virtual void _makeArrayNoTx( const r3d::Mesh&, vtkFloatArray*) const = 0;
+    virtual void _makeArray( const r3d::Mesh&, const vtkIntArray&, vtkFloatArray*) const = 0;
+
+    // Write the tuple for the given ID (already evaluated into vals) into the array.
+    virtual void _setTuple( const r3d::Mesh&, vtkFloatArray*, int id, const float *vals) const = 0;
+    virtual void _setTupleNoTx( const r3d::Mesh&, vtkFloatArray*, int id, const float *vals) const = 0;
+
+    // The number of IDs (faces or vertices) the metric is defined over, and the map from the
+    // actor's array tuples to these IDs (null if one-to-one).
+    virtual int _numIds( const r3d::Mesh&) const = 0;
+    virtual const vtkIntArray* _tupleMap( const vtkActor*) const = 0;
 
 private:
     const size_t _ndims;
+    size_t _nthreads;
+    void _evalRange( int id0, int n, float *out) const;
+    void _update( const r3d::Mesh&, vtkFloatArray*, const IntSet&, bool noTx) const;
     vtkSmartPointer<vtkFloatArray> _initArray( const r3d::Mesh&, const char*) const;
     SurfaceMapper( const SurfaceMapper&) = delete;
     void operator=( const SurfaceMapper&) = delete;
@@ -63,9 +142,23 @@ class r3dvis_EXPORT VertexSurfaceMapper : public SurfaceMapper
 {
 public:
     VertexSurfaceMapper( const MetricFn&, size_t);
+    VertexSurfaceMapper( const BatchMetricFn&, size_t);
 protected:
     void _makeArray( const r3d::Mesh&, vtkFloatArray*) const override;
     void _makeArrayNoTx( const r3d::Mesh&, vtkFloatArray*) const override;
+    void _makeArray( const r3d::Mesh&, const vtkIntArray&, vtkFloatArray*) const override;
+    void _setTuple( const r3d::Mesh&, vtkFloatArray*, int, const float*) const override;
+    void _setTupleNoTx( const r3d::Mesh&, vtkFloatArray*, int, const float*) const override;
+    int _numIds( const r3d::Mesh&) const override;
+    const vtkIntArray* _tupleMap( const vtkActor*) const override;
+private:
+    // Scratch buffer of per vertex values reused by each array build. Kept by the
+    // mapper rather than gathering through the point map per point so that each
+    // vertex's metric is evaluated only once (textured actors duplicate each vertex
+    // over every face using it). Callers of _vertexValues must hold _scratchLock.
+    mutable std::mutex _scratchLock;
+    mutable std::vector<float> _scratch;
+    const float* _vertexValues( int nv) const;
 };  // end class
 
 
@@ -73,9 +166,15 @@ class r3dvis_EXPORT FaceSurfaceMapper : public SurfaceMapper
 {
 public:
     FaceSurfaceMapper( const MetricFn&, size_t);
+    FaceSurfaceMapper( const BatchMetricFn&, size_t);
 protected:
     void _makeArray( const r3d::Mesh&, vtkFloatArray*) const override;
     void _makeArrayNoTx( const r3d::Mesh&, vtkFloatArray*) const override;
+    void _makeArray( const r3d::Mesh&, const vtkIntArray&, vtkFloatArray*) const override;
+    void _setTuple( const r3d::Mesh&, vtkFloatArray*, int, const float*) const override;
+    void _setTupleNoTx( const r3d::Mesh&, vtkFloatArray*, int, const float*) const override;
+    int _numIds( const r3d::Mesh&) const override;
+    const vtkIntArray* _tupleMap( const vtkActor*) const override;
 };  // end class
 
 }   // end namespace
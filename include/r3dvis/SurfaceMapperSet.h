@@ -0,0 +1,71 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_SURFACE_MAPPER_SET_H
+#define r3dvis_SURFACE_MAPPER_SET_H
+
+/**
+ * Builds the arrays for many named surface mappers in a single pass. Metrics are evaluated
+ * per vertex or face (optionally in parallel across mappers) and then all vertex metrics are
+ * fanned out together to the actor's points in one traversal of its point to vertex map.
+ * Vertex metric arrays are added to the actor's point data and face metric arrays to its
+ * cell data.
+ */
+
+#include "SurfaceMapper.h"
+#include <memory>
+#include <string>
+
+namespace r3dvis {
+
+class r3dvis_EXPORT SurfaceMapperSet
+{
+public:
+    using VMapper = std::shared_ptr<const VertexSurfaceMapper>;
+    using FMapper = std::shared_ptr<const FaceSurfaceMapper>;
+
+    SurfaceMapperSet();
+
+    // Add a named mapper. Names should be unique.
+    void add( const std::string &name, const VMapper&);
+    void add( const std::string &name, const FMapper&);
+
+    size_t size() const { return _vmappers.size() + _fmappers.size();}
+
+    // Evaluate up to n mappers concurrently (all hardware threads if zero). Only use if
+    // all of the metric functions are thread safe! Default 1.
+    void setNumThreads( size_t n);
+
+    // Make the arrays for the given actor generated from the mesh. Returned arrays are in
+    // order of addition for the vertex mappers followed by the face mappers.
+    std::vector<vtkSmartPointer<vtkFloatArray> > makeArrays( const vtkActor*, const r3d::Mesh&) const;
+
+    // Make the arrays and add them to the actor's point and cell data (replacing any
+    // existing arrays with the same names). Returns the number of arrays added.
+    size_t addArrays( vtkActor*, const r3d::Mesh&) const;
+
+private:
+    std::vector<std::pair<std::string, VMapper> > _vmappers;
+    std::vector<std::pair<std::string, FMapper> > _fmappers;
+    size_t _nthreads;
+
+    void _forEach( size_t n, const std::function<void(size_t)>&) const;
+};  // end class
+
+}   // end namespace
+
+#endif
@@ -26,6 +26,9 @@
 #define r3dvis_VIEWER_H
 
 #include "VTKTypes.h"
+#include "VtkTools.h"
+#include "MemoryFootprint.h"
+#include "RenderStats.h"
 #include <r3d/CameraParams.h>
 #include <memory>
 
@@ -87,8 +90,20 @@ public:
     int width() const;
     int height() const;
 
+    // Render the scene now regardless of whether it's changed since the last render.
 	void updateRender();
 
+    // The scene is dirty if it's been explicitly marked so since the last render or if the
+    // modification time of anything affecting its appearance (the window, renderer, camera,
+    // lights and the redraw times of the view props) is later than at the end of the last render.
+    // Call setDirty after changes VTK can't see (e.g. writing directly into an array's memory).
+    void setDirty() { _dirty = true;}
+    bool isDirty() const;
+
+    // Render only if dirty returning true iff a render took place. The extract functions
+    // below use this so a sequence of changes followed by an extract renders just once.
+    bool renderIfDirty();
+
     vtkRenderer* renderer() const { return _ren;}
 	vtkRenderWindow* renderWindow() const { return _renWin;}
 
@@ -98,9 +113,24 @@ public:
     // Extract Z buffer - ensure camera clipping range is set properly prior to using!
     cv::Mat_<float> extractZ();
 
+    // Render cell (face) and prop ID maps for everything visible in the window (see r3dvis::extractIds).
+    // The selection passes are the only renders done and they leave the viewer dirty.
+    IdBuffer extractIds();
+
+    // Host memory used by the actors of the scene (see MemoryFootprint).
+    MemoryFootprint memoryFootprint() const { return r3dvis::memoryFootprint( _ren.Get());}
+
+    // Instrumentation of rendering and the extract functions. Add sinks to start recording.
+    RenderStats &stats() { return _stats;}
+    const RenderStats &stats() const { return _stats;}
+
 private:
     vtkNew<vtkRenderer> _ren;
     vtkNew<vtkRenderWindow> _renWin;
+    RenderStats _stats;
+    bool _dirty;
+    vtkMTimeType _renderedMTime;
+    vtkMTimeType _sceneMTime() const;
 
     Viewer( const Viewer&) = delete;
     void operator=( const Viewer&) = delete;
@@ -28,6 +28,8 @@
 #include <vtkDistanceToCamera.h>
 #include <vtkPolyDataAlgorithm.h>
 #include <vtkGlyph3D.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
 #include <vtkActor.h>
 
 namespace r3dvis {
@@ -80,6 +82,8 @@ public:
 
 private:
     Vec3f _pos;
+    vtkNew<vtkPoints> _points;
+    vtkNew<vtkPolyData> _pset;
     vtkNew<vtkGlyph3D> _glyph;
     vtkNew<vtkDistanceToCamera> _d2cam;
     vtkNew<vtkActor> _actor;
@@ -0,0 +1,115 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef r3dvis_VTK_SCALING_ACTOR_SET_H
+#define r3dvis_VTK_SCALING_ACTOR_SET_H
+
+/**
+ * Many markers sharing a single glyph source drawn with a single (instanced) glyph mapper
+ * and actor. Like VtkScalingActor, markers can be scaled to remain a fixed size on screen.
+ * Marker positions are stored together and updated in place. Each marker has its own colour,
+ * visibility and pickability. Since there's only one actor, individual markers are picked
+ * with pickMarker rather than by picking the actor.
+ */
+
+#include "VtkScalingActor.h"
+#include "RendererPicker.h"
+#include <vtkUnsignedCharArray.h>
+#include <vtkDistanceToCamera.h>
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkGlyph3DMapper.h>
+#include <vtkBitArray.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+
+namespace r3dvis {
+
+class r3dvis_EXPORT VtkScalingActorSet
+{
+public:
+    explicit VtkScalingActorSet( vtkPolyDataAlgorithm* src);
+
+    // As with VtkScalingActor, it's up to the caller to add the prop to the renderer
+    // given to setRenderer (which is used for the distance to camera calculations).
+    const vtkActor* prop() const { return _actor;}
+    vtkActor* prop() { return _actor;}
+    void setRenderer( vtkRenderer*);
+    vtkRenderer* renderer() const;
+
+    void setFixedScale( bool);              // False initially.
+    bool fixedScale() const;
+
+    void setScaleFactor( double);
+    double scaleFactor() const;
+
+    void setOpacity( double);               // Opacity of all markers.
+    double opacity() const;
+
+    // Add a visible and pickable marker returning its index.
+    int add( const Vec3f&, const cv::Vec4b &rgba=cv::Vec4b(255,255,255,255));
+
+    // Set all marker positions at once. Markers are added or removed from the end as needed
+    // with new markers white, visible and pickable.
+    void setPositions( const std::vector<Vec3f>&);
+
+    // Remove all markers.
+    void clear();
+
+    int size() const { return int(_points->GetNumberOfPoints());}
+
+    void setPosition( int, const Vec3f&);
+    Vec3f position( int) const;
+
+    void setColour( int, const cv::Vec4b &rgba);
+    cv::Vec4b colour( int) const;
+
+    void setVisible( int, bool);
+    bool visible( int) const;
+
+    void setPickable( int, bool);
+    bool pickable( int) const;
+
+    // Return the index of the visible and pickable marker nearest to the given point (using
+    // the picker's point origin) that projects to within maxDist pixels of it, or -1 if none.
+    // Markers hidden behind rendered geometry (as read from the Z-buffer of the most recent render
+    // of the set's renderer) can't be picked. Markers count as visible if the surface seen at their
+    // centre is no nearer the camera than the front of their glyph.
+    int pickMarker( const RendererPicker&, const cv::Point&, int maxDist=8) const;
+
+private:
+    vtkSmartPointer<vtkPolyDataAlgorithm> _src;
+    vtkNew<vtkPoints> _points;
+    vtkNew<vtkUnsignedCharArray> _colours;
+    vtkNew<vtkBitArray> _mask;
+    vtkNew<vtkBitArray> _pickable;
+    vtkNew<vtkPolyData> _pset;
+    vtkNew<vtkDistanceToCamera> _d2cam;
+    vtkNew<vtkGlyph3DMapper> _mapper;
+    vtkNew<vtkActor> _actor;
+
+    void _modified();
+    double _sourceRadius() const;                   // Radius of the unscaled glyph source
+    double _glyphScale( vtkDataArray*, int) const;  // Scale of glyph i given the distance to camera array
+    void _depthTest( const std::vector<int>&, std::vector<bool>&) const;
+
+    VtkScalingActorSet( const VtkScalingActorSet&) = delete;
+    void operator=( const VtkScalingActorSet&) = delete;
+};  // end class
+
+}   // end namespace
+
+#endif
@@ -19,6 +19,7 @@
 #define r3dvis_VTK_Tools_H
 
 #include <r3d/Curvature.h>
+#include <unordered_set>
 #include <vector>
 #include <iostream>
 #include <vtkActor.h>
@@ -30,6 +31,7 @@
 #include <vtkImageData.h>
 #include <vtkMatrix4x4.h>
 #include <vtkFloatArray.h>
+#include <vtkIntArray.h>
 #include <vtkImageImport.h>
 #include <vtkLookupTable.h>
 #include <vtkSmartPointer.h>
@@ -90,13 +92,72 @@ r3dvis_EXPORT void extractBoundaryVertices( const vtkSmartPointer<vtkPolyData>&
 // Generate a set of normals from a vtkPolyData object having point and cell data.
 r3dvis_EXPORT vtkSmartPointer<vtkPolyData> generateNormals( vtkSmartPointer<vtkPolyData> pdata);
 
-// Make normals from a mesh's curvature data.
+// Make normals from a mesh's curvature data. The first version assumes the point layout
+// of an actor made by VtkActorCreator (three points per face if the mesh is textured).
+// The second uses the given actor's point to vertex map (see getPointVertexMap).
 r3dvis_EXPORT vtkSmartPointer<vtkFloatArray> makeNormals( const r3d::Curvature&);
+r3dvis_EXPORT vtkSmartPointer<vtkFloatArray> makeNormals( const r3d::Curvature&, const vtkActor*);
+
+// Name of the array in the field data of the poly data of textured actors made by
+// VtkActorCreator::generateActor that gives the mesh vertex ID of each actor point.
+constexpr char POINT_VERTEX_MAP[] = "r3dvis_PointVertexIds";
+
+// Make the point to vertex map for a textured actor made from the given mesh (three points per face
+// in face order). Pass to setPointVertexMap to store it on an actor or share it between actors.
+r3dvis_EXPORT vtkSmartPointer<vtkIntArray> makePointVertexMap( const r3d::Mesh&);
+r3dvis_EXPORT void setPointVertexMap( vtkActor*, vtkIntArray*);
+
+// Get the point to vertex map from the actor's poly data. Returns null if the actor doesn't
+// have one, in which case its points are taken to map one-to-one with the mesh vertices.
+r3dvis_EXPORT vtkIntArray* getPointVertexMap( const vtkActor*);
+
+// Make a per point array by gathering the given row-major per vertex tuples (nvtxs x ncomps)
+// through the point to vertex map, or copying them one-to-one if the map is null.
+r3dvis_EXPORT vtkSmartPointer<vtkFloatArray> gatherVertexTuples( const float *vtuples, int nvtxs, int ncomps,
+                                                                  const vtkIntArray *pvmap=nullptr);
+
+// Make per point normals for an actor from per vertex normals using the actor's point to vertex map.
+r3dvis_EXPORT vtkSmartPointer<vtkFloatArray> makeNormals( const r3d::MatX3f&, const vtkIntArray *pvmap=nullptr);
 
 // Dump a colour or Z buffer image from the provided vtkRenderWindow.
 r3dvis_EXPORT cv::Mat_<cv::Vec3b> extractBGR( vtkRenderWindow*);
 r3dvis_EXPORT cv::Mat_<float> extractZ( vtkRenderWindow*);
 
+// Per pixel IDs of the visible cells and props from a single hardware selection
+// capture over the whole of a renderer's viewport. Images use a top left origin.
+struct r3dvis_EXPORT IdBuffer
+{
+    cv::Mat_<int> cellIds;  // ID of the visible cell (face) of the prop, or -1 for background.
+    cv::Mat_<int> propIds;  // Index into props of the visible prop, or -1 for background.
+    std::vector<const vtkProp*> props;  // The props seen in the capture.
+};  // end struct
+
+// Capture the IDs of the visible cells and pickable props in the given renderer.
+// Since actors created by VtkActorCreator have cells in the same order as the faces
+// of their source mesh, the cell IDs of these actors are also their mesh face IDs.
+// The selection passes overwrite the frame buffer so the renderer is marked modified
+// (making a Viewer using it dirty) and must be rendered again before reading pixels.
+r3dvis_EXPORT IdBuffer extractIds( vtkRenderer*);
+
+// As above but only the given props are rendered in the selection passes so other props
+// can't occlude them. The props themselves aren't modified.
+r3dvis_EXPORT IdBuffer extractIds( vtkRenderer*, const std::unordered_set<const vtkProp*>&);
+
+// Read the colour or Z-buffer of the given renderer's viewport as left by the most
+// recent render (no rendering is done). Returned images use a top left origin.
+r3dvis_EXPORT cv::Mat_<cv::Vec3b> readBGR( vtkRenderer*);
+r3dvis_EXPORT cv::Mat_<float> readZ( vtkRenderer*);
+
+// Read the colour buffer into dst without allocating. The pixels are read straight
+// into dst's memory which must be continuous and the size of the viewport. Returns
+// false (with dst untouched) if it isn't.
+r3dvis_EXPORT bool readBGR( vtkRenderer*, cv::Mat_<cv::Vec3b> &dst);
+
+// Return the composite projection matrix for the renderer's active camera. This maps
+// homogeneous world coordinates to view coordinates with x and y in [-1,1] and z in
+// [0,1] to match the values in the Z-buffer. Invert it to unproject Z-buffer values.
+r3dvis_EXPORT Eigen::Matrix4d compositeProjection( vtkRenderer*);
+
 // Convert the given VTK image data to an OpenCV image.
 r3dvis_EXPORT cv::Mat toCV( const vtkImageData*);
 
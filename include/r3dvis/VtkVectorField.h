@@ -18,9 +18,22 @@
 #ifndef r3dvis_VTK_VECTOR_FIELD_H
 #define r3dvis_VTK_VECTOR_FIELD_H
 
-#include "r3dvis_Export.h"
+/**
+ * Arrow glyphs drawn at the points of a polydata in the direction of its vectors or normals.
+ * By default, the glyphs are generated as geometry with vtkGlyph3D which copies the whole arrow
+ * for every input point. In instanced mode, a vtkGlyph3DMapper draws the single arrow source
+ * at every point on the GPU instead which is far cheaper for large fields. In both modes the
+ * glyphs are scaled by the input's point scalars (if it has any) times the scale factor.
+ */
+
+#include "LookupTable.h"
+#include <r3d/Curvature.h>
 #include <vtkLookupTable.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkArrowSource.h>
+#include <vtkWeakPointer.h>
+#include <vtkMaskPoints.h>
+#include <vtkRenderer.h>
 #include <vtkGlyph3D.h>
 #include <vtkPolyData.h>
 #include <vtkActor.h>
@@ -34,9 +47,26 @@ public:
     using Ptr = std::shared_ptr<VtkVectorField>;
 
     // If useNormal is false, the vector array set on the polydata will be used.
-    static Ptr create( const vtkPolyData*, bool useNormal=false);
+    // If instanced is true, glyphs are drawn with a vtkGlyph3DMapper.
+    static Ptr create( const vtkPolyData*, bool useNormal=false, bool instanced=false);
 
-    explicit VtkVectorField( const vtkPolyData*, bool useNormal=false);
+    // Create a field of vectors (one row per vertex) at the vertices of the given mesh which
+    // must have sequential IDs. The actor's transform is set from the mesh's transform matrix.
+    // Arrows are scaled by vector length (multiplied by the scale factor). If the vectors are
+    // stored row major, the VTK vector array wraps them without copying in which case they
+    // must outlive the returned field. If a lookup table is given, arrows are coloured by their
+    // lengths over the range of lengths (or over [0,max length] if the lengths are all about
+    // the same, e.g. unit normals). Returns null if the mesh and vectors don't match.
+    static Ptr create( const r3d::Mesh&, const r3d::MatX3f&, bool instanced=false, const LookupTable *lut=nullptr);
+
+    // As above but shows the vertex normals of the given curvature's mesh. The normals are
+    // wrapped without copying when row major so the Curvature must outlive the returned field.
+    static Ptr create( const r3d::Curvature&, bool instanced=false, const LookupTable *lut=nullptr);
+
+    VtkVectorField( const vtkPolyData*, bool useNormal=false, bool instanced=false);
+    ~VtkVectorField();
+
+    bool instanced() const { return _instanced;}
 
     // Caller must ensure that the renderer the prop is added to
     // corresponds with the vtkLookupTable set (if any).
@@ -49,6 +79,22 @@ public:
     void setScaleFactor( double);
     double scaleFactor() const;
 
+    // Set the number of facets around the arrow's tip and shaft (both 6 initially).
+    void setArrowResolution( int);
+    int arrowResolution() const;
+
+    // Subsample the input points so that glyph density on screen stays at around one glyph
+    // per pixelsPerGlyph x pixelsPerGlyph pixel block of the field's projected screen bounds.
+    // The sampling stride is recalculated at the start of every render of the given renderer
+    // (which should be the one the prop is added to) so glyph count adapts to zoom level.
+    // Strides are powers of two so zooming in only ever adds glyphs to those already shown.
+    // Pass a null renderer to stop subsampling and show glyphs at every point again.
+    void setSubsampling( vtkRenderer*, int pixelsPerGlyph=16);
+    int pixelsPerGlyph() const { return _pxPerGlyph;}
+
+    // The current sampling stride (1 if not subsampling).
+    int sampleStride() const;
+
     void setVisible( bool);
     bool visible() const;
 
@@ -69,9 +115,21 @@ public:
     void copyProperties( const VtkVectorField&);
 
 private:
+    const vtkPolyData *_input;
+    const bool _instanced;
     vtkNew<vtkArrowSource> _arrow;
+    vtkNew<vtkMaskPoints> _mask;
     vtkNew<vtkGlyph3D> _glyph;
+    vtkNew<vtkGlyph3DMapper> _gmapper;
     vtkNew<vtkActor> _actor;
+    vtkWeakPointer<vtkRenderer> _ren;
+    unsigned long _observerTag;
+    int _pxPerGlyph;
+
+    void _setGlyphInput( vtkAlgorithmOutput*);
+    void _scaleByVector();
+    void _updateStride();
+    static void _onRenderStart( vtkObject*, unsigned long, void*, void*);
 
     VtkVectorField( const VtkVectorField&) = delete;
     void operator=( const VtkVectorField&) = delete;
@@ -0,0 +1,106 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <ActorPickContext.h>
+#include <VtkTools.h>
+#include <algorithm>
+#include <cassert>
+using r3dvis::ActorPickContext;
+
+
+ActorPickContext::ActorPickContext( vtkRenderer *ren, const std::vector<const vtkProp*> &props, PointOrigin po)
+    : _ren(ren), _pointOrigin(po)
+{
+    assert(ren);
+    _ppicker->PickFromListOn();
+    for ( const vtkProp *p : props)
+        add(p);
+}   // end ctor
+
+
+void ActorPickContext::add( const vtkProp *p)
+{
+    if ( p && _cset.insert(p).second)
+        _ppicker->AddPickList( const_cast<vtkProp*>(p));
+}   // end add
+
+
+void ActorPickContext::remove( const vtkProp *p)
+{
+    if ( _cset.erase(p) > 0)
+        _ppicker->DeletePickList( const_cast<vtkProp*>(p));
+}   // end remove
+
+
+void ActorPickContext::clear()
+{
+    _cset.clear();
+    _ppicker->InitializePickList();
+}   // end clear
+
+
+const vtkActor* ActorPickContext::pickActor( const cv::Point &p) const
+{
+    if ( _cset.empty() || !RendererPicker::isValidPoint( _ren, p))
+        return nullptr;
+    const cv::Point np = RendererPicker::toBottomLeft( _ren, p, _pointOrigin);
+    const int picked = _ppicker->Pick( np.x, np.y, 0, _ren);
+    _ren->Modified();   // The selection pass overwrites the frame buffer
+    return picked > 0 ? _ppicker->GetActor() : nullptr;
+}   // end pickActor
+
+
+const vtkActor* ActorPickContext::pickActor( const cv::Point2f &p) const
+{
+    return pickActor( RendererPicker::toPixels( _ren, p));
+}   // end pickActor
+
+
+size_t ActorPickContext::pickActors( const std::vector<cv::Point> &pts, std::vector<const vtkActor*> &actors) const
+{
+    actors.assign( pts.size(), nullptr);
+    if ( _cset.empty() || pts.empty())
+        return 0;
+
+    // Only the candidates are rendered so other props can't occlude them.
+    const IdBuffer ibuf = extractIds( _ren, _cset);   // Top left origin
+
+    const int h = ibuf.propIds.rows;
+    size_t nhits = 0;
+    for ( size_t i = 0; i < pts.size(); ++i)
+    {
+        if ( !RendererPicker::isValidPoint( _ren, pts[i]))
+            continue;
+        const cv::Point p = RendererPicker::toBottomLeft( _ren, pts[i], _pointOrigin);
+        const int pidx = ibuf.propIds( h - p.y - 1, p.x);
+        if ( pidx < 0)
+            continue;
+        actors[i] = vtkActor::SafeDownCast( const_cast<vtkProp*>( ibuf.props[pidx]));
+        if ( actors[i])
+            nhits++;
+    }   // end for
+    return nhits;
+}   // end pickActors
+
+
+size_t ActorPickContext::pickActors( const std::vector<cv::Point2f> &pts, std::vector<const vtkActor*> &actors) const
+{
+    std::vector<cv::Point> ipts( pts.size());
+    for ( size_t i = 0; i < pts.size(); ++i)
+        ipts[i] = RendererPicker::toPixels( _ren, pts[i]);
+    return pickActors( ipts, actors);
+}   // end pickActors
@@ -0,0 +1,177 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <ColourMapper.h>
+#include <VtkTools.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <Eigen/Dense>
+#include <cstring>
+#include <limits>
+#include <cassert>
+#include <cmath>
+using r3dvis::ColourMapper;
+using r3dvis::LookupTable;
+
+const char *ColourMapper::ARRAY_NAME = "r3dvis_Colours";
+
+
+uint32_t ColourMapper::_pack( const cv::Vec4b &c)
+{
+    uint32_t v;
+    memcpy( &v, &c[0], 4);  // Keeps RGBA byte order in memory
+    return v;
+}   // end _pack
+
+
+ColourMapper::ColourMapper( const LookupTable &lut, float minv, float maxv, Mode m)
+    : _mode(m), _nbands(10),
+      _nanCol( _pack( cv::Vec4b(128,128,128,255))), _belowCol(0), _aboveCol(0),
+      _useBelow(false), _useAbove(false)
+{
+    setLookupTable( lut);
+    setRange( minv, maxv);
+}   // end ctor
+
+
+void ColourMapper::setLookupTable( const LookupTable &lut)
+{
+    const std::vector<rimg::Colour> &cols = lut.colours();
+    _cols.resize( std::max<size_t>( cols.size(), 1));
+    _cols[0] = _pack( cv::Vec4b(0,0,0,255));
+    for ( size_t i = 0; i < cols.size(); ++i)
+        _cols[i] = _pack( cv::Vec4b( uint8_t(cols[i].ired()), uint8_t(cols[i].igreen()), uint8_t(cols[i].iblue()), 255));
+}   // end setLookupTable
+
+
+void ColourMapper::setRange( float minv, float maxv)
+{
+    _minv = std::min( minv, maxv);
+    _maxv = std::max( minv, maxv);
+}   // end setRange
+
+
+namespace {
+const size_t BLOCK = 256;   // Values converted per vectorised block
+}   // end namespace
+
+
+void ColourMapper::map( const float *vals, size_t n, uint8_t *rgba, size_t stride) const
+{
+    using ArrayB = Eigen::Array<float, Eigen::Dynamic, 1>;
+    using Stride = Eigen::InnerStride<Eigen::Dynamic>;
+
+    // Work out t = a*f(v) + b in [0,1] over the range where f is the identity or log.
+    const bool isLog = _mode == LOG;
+    float lo = _minv;
+    float hi = _maxv;
+    if ( isLog)
+    {
+        lo = logf( std::max( _minv, std::numeric_limits<float>::min()));
+        hi = logf( std::max( _maxv, std::numeric_limits<float>::min()));
+    }   // end if
+    const float a = hi > lo ? 1.0f / (hi - lo) : 0.0f;
+    const float b = -lo * a;
+
+    const int ncols = int(_cols.size());
+    const float nbands = float(_nbands);
+    const uint32_t below = _useBelow ? _belowCol : _cols.front();
+    const uint32_t above = _useAbove ? _aboveCol : _cols.back();
+    uint32_t *out = reinterpret_cast<uint32_t*>(rgba);   // RGBA8 byte order preserved
+
+    ArrayB t( BLOCK);
+    ArrayB idx( BLOCK);
+    for ( size_t i0 = 0; i0 < n; i0 += BLOCK)
+    {
+        const Eigen::Index m = Eigen::Index( std::min( BLOCK, n - i0));
+        const Eigen::Map<const ArrayB, 0, Stride> v( vals + i0*stride, m, Stride( Eigen::Index(stride)));
+
+        // Vectorised part
+        if ( isLog)
+            t.head(m) = v.log() * a + b;    // NaN for v < 0 and -inf for v == 0
+        else
+            t.head(m) = v * a + b;
+        if ( _mode == BANDED)
+            idx.head(m) = (((t.head(m) * nbands).floor() + 0.5f) / nbands * float(ncols)).floor();
+        else
+            idx.head(m) = (t.head(m) * float(ncols)).floor();
+        idx.head(m) = idx.head(m).max(0.0f).min( float(ncols-1));
+
+        // Table lookup (gather) and out of range classification
+        for ( Eigen::Index j = 0; j < m; ++j)
+        {
+            const float vj = v[j];
+            const float tj = t[j];
+            uint32_t c;
+            if ( std::isnan(vj))
+                c = _nanCol;
+            else if ( !(tj >= 0.0f))  // Also catches NaN from log of negative values
+                c = below;
+            else if ( tj > 1.0f)
+                c = above;
+            else
+                c = _cols[size_t(idx[j])];
+            memcpy( out++, &c, 4);
+        }   // end for
+    }   // end for
+}   // end map
+
+
+vtkSmartPointer<vtkUnsignedCharArray> ColourMapper::map( const vtkFloatArray *vals, int k) const
+{
+    vtkFloatArray *fa = const_cast<vtkFloatArray*>(vals);
+    const int nc = fa->GetNumberOfComponents();
+    assert( k >= 0 && k < nc);
+    const vtkIdType n = fa->GetNumberOfTuples();
+    vtkSmartPointer<vtkUnsignedCharArray> cols = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    cols->SetNumberOfComponents(4);
+    cols->SetNumberOfTuples( n);
+    cols->SetName( ARRAY_NAME);
+    map( fa->GetPointer(0) + k, size_t(n), cols->GetPointer(0), size_t(nc));
+    return cols;
+}   // end map
+
+
+void ColourMapper::apply( vtkActor *actor, const vtkFloatArray *vals, bool cellData, int k) const
+{
+    vtkPolyData *pd = getPolyData( actor);
+    if ( !pd)
+        return;
+    vtkDataSetAttributes *attr = cellData ? static_cast<vtkDataSetAttributes*>(pd->GetCellData())
+                                          : static_cast<vtkDataSetAttributes*>(pd->GetPointData());
+
+    vtkFloatArray *fa = const_cast<vtkFloatArray*>(vals);
+    const vtkIdType n = fa->GetNumberOfTuples();
+    vtkUnsignedCharArray *cols = vtkUnsignedCharArray::SafeDownCast( attr->GetArray( ARRAY_NAME));
+    if ( cols && cols->GetNumberOfComponents() == 4 && cols->GetNumberOfTuples() == n)
+    {
+        map( fa->GetPointer(0) + k, size_t(n), cols->GetPointer(0), size_t(fa->GetNumberOfComponents()));
+        cols->Modified();
+    }   // end if
+    else
+        attr->AddArray( map( vals, k));
+    attr->SetActiveScalars( ARRAY_NAME);
+
+    vtkMapper *mapper = actor->GetMapper();
+    mapper->SetColorModeToDirectScalars();
+    if ( cellData)
+        mapper->SetScalarModeToUseCellData();
+    else
+        mapper->SetScalarModeToUsePointData();
+    mapper->ScalarVisibilityOn();
+}   // end apply
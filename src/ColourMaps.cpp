@@ -0,0 +1,194 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <ColourMaps.h>
+using r3dvis::ColourMap;
+
+
+namespace {
+
+struct Table
+{
+    uint8_t rgb[3*r3dvis::COLOUR_MAP_SIZE];
+};  // end struct
+
+
+// The matplotlib viridis, magma and cividis tables and Moreland's smooth cool-warm map
+// (as sampled by matplotlib's coolwarm) as RGB bytes.
+constexpr Table VIRIDIS = {{
+     68,  1, 84,  68,  2, 86,  69,  4, 87,  69,  5, 89,  70,  7, 90,  70,  8, 92,  70, 10, 93,  70, 11, 94,
+     71, 13, 96,  71, 14, 97,  71, 16, 99,  71, 17,100,  71, 19,101,  72, 20,103,  72, 22,104,  72, 23,105,
+     72, 24,106,  72, 26,108,  72, 27,109,  72, 28,110,  72, 29,111,  72, 31,112,  72, 32,113,  72, 33,115,
+     72, 35,116,  72, 36,117,  72, 37,118,  72, 38,119,  72, 40,120,  72, 41,121,  71, 42,122,  71, 44,122,
+     71, 45,123,  71, 46,124,  71, 47,125,  70, 48,126,  70, 50,126,  70, 51,127,  70, 52,128,  69, 53,129,
+     69, 55,129,  69, 56,130,  68, 57,131,  68, 58,131,  68, 59,132,  67, 61,132,  67, 62,133,  66, 63,133,
+     66, 64,134,  66, 65,134,  65, 66,135,  65, 68,135,  64, 69,136,  64, 70,136,  63, 71,136,  63, 72,137,
+     62, 73,137,  62, 74,137,  62, 76,138,  61, 77,138,  61, 78,138,  60, 79,138,  60, 80,139,  59, 81,139,
+     59, 82,139,  58, 83,139,  58, 84,140,  57, 85,140,  57, 86,140,  56, 88,140,  56, 89,140,  55, 90,140,
+     55, 91,141,  54, 92,141,  54, 93,141,  53, 94,141,  53, 95,141,  52, 96,141,  52, 97,141,  51, 98,141,
+     51, 99,141,  50,100,142,  50,101,142,  49,102,142,  49,103,142,  49,104,142,  48,105,142,  48,106,142,
+     47,107,142,  47,108,142,  46,109,142,  46,110,142,  46,111,142,  45,112,142,  45,113,142,  44,113,142,
+     44,114,142,  44,115,142,  43,116,142,  43,117,142,  42,118,142,  42,119,142,  42,120,142,  41,121,142,
+     41,122,142,  41,123,142,  40,124,142,  40,125,142,  39,126,142,  39,127,142,  39,128,142,  38,129,142,
+     38,130,142,  38,130,142,  37,131,142,  37,132,142,  37,133,142,  36,134,142,  36,135,142,  35,136,142,
+     35,137,142,  35,138,141,  34,139,141,  34,140,141,  34,141,141,  33,142,141,  33,143,141,  33,144,141,
+     33,145,140,  32,146,140,  32,146,140,  32,147,140,  31,148,140,  31,149,139,  31,150,139,  31,151,139,
+     31,152,139,  31,153,138,  31,154,138,  30,155,138,  30,156,137,  30,157,137,  31,158,137,  31,159,136,
+     31,160,136,  31,161,136,  31,161,135,  31,162,135,  32,163,134,  32,164,134,  33,165,133,  33,166,133,
+     34,167,133,  34,168,132,  35,169,131,  36,170,131,  37,171,130,  37,172,130,  38,173,129,  39,173,129,
+     40,174,128,  41,175,127,  42,176,127,  44,177,126,  45,178,125,  46,179,124,  47,180,124,  49,181,123,
+     50,182,122,  52,182,121,  53,183,121,  55,184,120,  56,185,119,  58,186,118,  59,187,117,  61,188,116,
+     63,188,115,  64,189,114,  66,190,113,  68,191,112,  70,192,111,  72,193,110,  74,193,109,  76,194,108,
+     78,195,107,  80,196,106,  82,197,105,  84,197,104,  86,198,103,  88,199,101,  90,200,100,  92,200, 99,
+     94,201, 98,  96,202, 96,  99,203, 95, 101,203, 94, 103,204, 92, 105,205, 91, 108,205, 90, 110,206, 88,
+    112,207, 87, 115,208, 86, 117,208, 84, 119,209, 83, 122,209, 81, 124,210, 80, 127,211, 78, 129,211, 77,
+    132,212, 75, 134,213, 73, 137,213, 72, 139,214, 70, 142,214, 69, 144,215, 67, 147,215, 65, 149,216, 64,
+    152,216, 62, 155,217, 60, 157,217, 59, 160,218, 57, 162,218, 55, 165,219, 54, 168,219, 52, 170,220, 50,
+    173,220, 48, 176,221, 47, 178,221, 45, 181,222, 43, 184,222, 41, 186,222, 40, 189,223, 38, 192,223, 37,
+    194,223, 35, 197,224, 33, 200,224, 32, 202,225, 31, 205,225, 29, 208,225, 28, 210,226, 27, 213,226, 26,
+    216,226, 25, 218,227, 25, 221,227, 24, 223,227, 24, 226,228, 24, 229,228, 25, 231,228, 25, 234,229, 26,
+    236,229, 27, 239,229, 28, 241,229, 29, 244,230, 30, 246,230, 32, 248,230, 33, 251,231, 35, 253,231, 37}};
+
+constexpr Table MAGMA = {{
+      0,  0,  4,   1,  0,  5,   1,  1,  6,   1,  1,  8,   2,  1,  9,   2,  2, 11,   2,  2, 13,   3,  3, 15,
+      3,  3, 18,   4,  4, 20,   5,  4, 22,   6,  5, 24,   6,  5, 26,   7,  6, 28,   8,  7, 30,   9,  7, 32,
+     10,  8, 34,  11,  9, 36,  12,  9, 38,  13, 10, 41,  14, 11, 43,  16, 11, 45,  17, 12, 47,  18, 13, 49,
+     19, 13, 52,  20, 14, 54,  21, 14, 56,  22, 15, 59,  24, 15, 61,  25, 16, 63,  26, 16, 66,  28, 16, 68,
+     29, 17, 71,  30, 17, 73,  32, 17, 75,  33, 17, 78,  34, 17, 80,  36, 18, 83,  37, 18, 85,  39, 18, 88,
+     41, 17, 90,  42, 17, 92,  44, 17, 95,  45, 17, 97,  47, 17, 99,  49, 17,101,  51, 16,103,  52, 16,105,
+     54, 16,107,  56, 16,108,  57, 15,110,  59, 15,112,  61, 15,113,  63, 15,114,  64, 15,116,  66, 15,117,
+     68, 15,118,  69, 16,119,  71, 16,120,  73, 16,120,  74, 16,121,  76, 17,122,  78, 17,123,  79, 18,123,
+     81, 18,124,  82, 19,124,  84, 19,125,  86, 20,125,  87, 21,126,  89, 21,126,  90, 22,126,  92, 22,127,
+     93, 23,127,  95, 24,127,  96, 24,128,  98, 25,128, 100, 26,128, 101, 26,128, 103, 27,128, 104, 28,129,
+    106, 28,129, 107, 29,129, 109, 29,129, 110, 30,129, 112, 31,129, 114, 31,129, 115, 32,129, 117, 33,129,
+    118, 33,129, 120, 34,129, 121, 34,130, 123, 35,130, 124, 35,130, 126, 36,130, 128, 37,130, 129, 37,129,
+    131, 38,129, 132, 38,129, 134, 39,129, 136, 39,129, 137, 40,129, 139, 41,129, 140, 41,129, 142, 42,129,
+    144, 42,129, 145, 43,129, 147, 43,128, 148, 44,128, 150, 44,128, 152, 45,128, 153, 45,128, 155, 46,127,
+    156, 46,127, 158, 47,127, 160, 47,127, 161, 48,126, 163, 48,126, 165, 49,126, 166, 49,125, 168, 50,125,
+    170, 51,125, 171, 51,124, 173, 52,124, 174, 52,123, 176, 53,123, 178, 53,123, 179, 54,122, 181, 54,122,
+    183, 55,121, 184, 55,121, 186, 56,120, 188, 57,120, 189, 57,119, 191, 58,119, 192, 58,118, 194, 59,117,
+    196, 60,117, 197, 60,116, 199, 61,115, 200, 62,115, 202, 62,114, 204, 63,113, 205, 64,113, 207, 64,112,
+    208, 65,111, 210, 66,111, 211, 67,110, 213, 68,109, 214, 69,108, 216, 69,108, 217, 70,107, 219, 71,106,
+    220, 72,105, 222, 73,104, 223, 74,104, 224, 76,103, 226, 77,102, 227, 78,101, 228, 79,100, 229, 80,100,
+    231, 82, 99, 232, 83, 98, 233, 84, 98, 234, 86, 97, 235, 87, 96, 236, 88, 96, 237, 90, 95, 238, 91, 94,
+    239, 93, 94, 240, 95, 94, 241, 96, 93, 242, 98, 93, 242,100, 92, 243,101, 92, 244,103, 92, 244,105, 92,
+    245,107, 92, 246,108, 92, 246,110, 92, 247,112, 92, 247,114, 92, 248,116, 92, 248,118, 92, 249,120, 93,
+    249,121, 93, 249,123, 93, 250,125, 94, 250,127, 94, 250,129, 95, 251,131, 95, 251,133, 96, 251,135, 97,
+    252,137, 97, 252,138, 98, 252,140, 99, 252,142,100, 252,144,101, 253,146,102, 253,148,103, 253,150,104,
+    253,152,105, 253,154,106, 253,155,107, 254,157,108, 254,159,109, 254,161,110, 254,163,111, 254,165,113,
+    254,167,114, 254,169,115, 254,170,116, 254,172,118, 254,174,119, 254,176,120, 254,178,122, 254,180,123,
+    254,182,124, 254,183,126, 254,185,127, 254,187,129, 254,189,130, 254,191,132, 254,193,133, 254,194,135,
+    254,196,136, 254,198,138, 254,200,140, 254,202,141, 254,204,143, 254,205,144, 254,207,146, 254,209,148,
+    254,211,149, 254,213,151, 254,215,153, 254,216,154, 253,218,156, 253,220,158, 253,222,160, 253,224,161,
+    253,226,163, 253,227,165, 253,229,167, 253,231,169, 253,233,170, 253,235,172, 252,236,174, 252,238,176,
+    252,240,178, 252,242,180, 252,244,182, 252,246,184, 252,247,185, 252,249,187, 252,251,189, 252,253,191}};
+
+constexpr Table CIVIDIS = {{
+      0, 34, 78,   0, 35, 79,   0, 36, 81,   0, 37, 83,   0, 37, 84,   0, 38, 86,   0, 39, 88,   0, 40, 89,
+      0, 40, 91,   0, 41, 93,   0, 42, 95,   0, 42, 97,   0, 43, 98,   0, 44,100,   0, 44,102,   0, 45,104,
+      0, 46,106,   0, 46,108,   0, 47,109,   0, 48,111,   0, 48,112,   0, 49,112,   0, 49,113,   1, 50,113,
+      5, 51,113,   8, 51,112,  12, 52,112,  15, 53,112,  18, 53,112,  20, 54,112,  22, 55,112,  24, 55,111,
+     26, 56,111,  28, 57,111,  30, 58,111,  32, 58,111,  33, 59,110,  35, 60,110,  36, 60,110,  38, 61,110,
+     39, 62,110,  41, 63,110,  42, 63,109,  43, 64,109,  45, 65,109,  46, 65,109,  47, 66,109,  49, 67,109,
+     50, 67,109,  51, 68,109,  52, 69,108,  53, 69,108,  54, 70,108,  56, 71,108,  57, 72,108,  58, 72,108,
+     59, 73,108,  60, 74,108,  61, 74,108,  62, 75,108,  63, 76,108,  64, 76,108,  65, 77,108,  66, 78,108,
+     67, 78,108,  68, 79,108,  69, 80,108,  70, 81,108,  71, 81,108,  72, 82,108,  73, 83,108,  74, 83,108,
+     75, 84,108,  76, 85,108,  77, 85,108,  78, 86,108,  79, 87,108,  80, 87,108,  81, 88,109,  82, 89,109,
+     83, 90,109,  84, 90,109,  85, 91,109,  85, 92,109,  86, 92,109,  87, 93,109,  88, 94,109,  89, 94,110,
+     90, 95,110,  91, 96,110,  92, 97,110,  93, 97,110,  94, 98,110,  94, 99,111,  95, 99,111,  96,100,111,
+     97,101,111,  98,101,111,  99,102,112, 100,103,112, 101,104,112, 101,104,112, 102,105,112, 103,106,113,
+    104,106,113, 105,107,113, 106,108,113, 107,109,114, 108,109,114, 108,110,114, 109,111,114, 110,111,115,
+    111,112,115, 112,113,115, 113,114,116, 114,114,116, 114,115,116, 115,116,117, 116,116,117, 117,117,117,
+    118,118,118, 119,119,118, 119,119,119, 120,120,119, 121,121,119, 122,122,120, 123,122,120, 124,123,120,
+    125,124,120, 126,124,120, 126,125,120, 127,126,120, 128,127,120, 129,127,120, 130,128,121, 131,129,121,
+    132,130,121, 133,130,121, 134,131,121, 135,132,120, 136,133,120, 137,133,120, 138,134,120, 139,135,120,
+    140,136,120, 141,136,120, 142,137,120, 143,138,120, 144,139,120, 145,139,120, 146,140,120, 146,141,120,
+    147,142,120, 148,142,119, 149,143,119, 150,144,119, 151,145,119, 152,146,119, 153,146,119, 154,147,118,
+    155,148,118, 156,149,118, 157,149,118, 158,150,118, 159,151,117, 160,152,117, 161,153,117, 162,153,117,
+    163,154,116, 164,155,116, 165,156,116, 166,156,116, 167,157,115, 168,158,115, 169,159,115, 170,160,115,
+    171,160,114, 172,161,114, 173,162,114, 174,163,113, 175,164,113, 176,165,113, 177,165,112, 179,166,112,
+    180,167,111, 181,168,111, 182,169,111, 183,169,110, 184,170,110, 185,171,109, 186,172,109, 187,173,109,
+    188,174,108, 189,174,108, 190,175,107, 191,176,107, 192,177,106, 193,178,106, 194,179,105, 195,179,105,
+    196,180,104, 197,181,104, 198,182,103, 199,183,103, 200,184,102, 201,185,101, 203,185,101, 204,186,100,
+    205,187, 99, 206,188, 99, 207,189, 98, 208,190, 98, 209,191, 97, 210,192, 96, 211,192, 95, 212,193, 95,
+    213,194, 94, 214,195, 93, 215,196, 92, 217,197, 92, 218,198, 91, 219,199, 90, 220,200, 89, 221,200, 88,
+    222,201, 88, 223,202, 87, 224,203, 86, 225,204, 85, 226,205, 84, 228,206, 83, 229,207, 82, 230,208, 81,
+    231,209, 80, 232,210, 79, 233,211, 78, 234,211, 76, 235,212, 75, 237,213, 74, 238,214, 73, 239,215, 72,
+    240,216, 70, 241,217, 69, 242,218, 68, 243,219, 66, 245,220, 65, 246,221, 63, 247,222, 62, 248,223, 60,
+    249,224, 58, 251,225, 56, 252,226, 54, 253,227, 52, 254,228, 52, 254,229, 53, 254,230, 54, 254,232, 56}};
+
+constexpr Table COOLWARM = {{
+     59, 76,192,  60, 78,194,  61, 80,195,  62, 81,197,  63, 83,198,  64, 85,200,  66, 87,201,  67, 88,203,
+     68, 90,204,  69, 92,206,  70, 94,207,  72, 95,209,  73, 97,210,  74, 99,211,  75,100,213,  76,102,214,
+     78,104,216,  79,105,217,  80,107,218,  81,109,219,  83,110,221,  84,112,222,  85,114,223,  86,115,224,
+     88,117,225,  89,119,227,  90,120,228,  91,122,229,  93,124,230,  94,125,231,  95,127,232,  97,128,233,
+     98,130,234,  99,132,235, 100,133,236, 102,135,237, 103,136,238, 104,138,239, 106,139,239, 107,141,240,
+    108,143,241, 110,144,242, 111,146,243, 112,147,243, 114,149,244, 115,150,245, 117,151,246, 118,153,246,
+    119,154,247, 121,156,248, 122,157,248, 123,159,249, 125,160,249, 126,161,250, 128,163,250, 129,164,251,
+    130,166,251, 132,167,252, 133,168,252, 134,169,252, 136,171,253, 137,172,253, 139,173,253, 140,175,254,
+    141,176,254, 143,177,254, 144,178,254, 146,180,254, 147,181,254, 148,182,255, 150,183,255, 151,184,255,
+    152,185,255, 154,187,255, 155,188,255, 157,189,255, 158,190,255, 159,191,255, 161,192,255, 162,193,255,
+    163,194,254, 165,195,254, 166,196,254, 167,197,254, 169,198,253, 170,199,253, 171,200,253, 173,201,253,
+    174,201,252, 175,202,252, 177,203,252, 178,204,251, 179,205,251, 181,205,250, 182,206,250, 183,207,249,
+    185,208,249, 186,208,248, 187,209,248, 188,210,247, 190,210,246, 191,211,246, 192,212,245, 193,212,244,
+    195,213,244, 196,213,243, 197,214,242, 198,214,241, 199,215,240, 201,215,240, 202,216,239, 203,216,238,
+    204,217,237, 205,217,236, 206,218,235, 207,218,234, 209,218,233, 210,219,232, 211,219,231, 212,219,230,
+    213,219,229, 214,220,228, 215,220,227, 216,220,226, 217,220,225, 218,220,224, 219,220,222, 220,221,221,
+    221,220,220, 222,220,219, 223,219,217, 224,219,216, 225,218,214, 226,218,213, 227,217,211, 228,217,210,
+    229,216,209, 230,215,207, 231,215,206, 232,214,204, 233,213,203, 234,213,201, 234,212,200, 235,211,198,
+    236,211,197, 237,210,195, 237,209,194, 238,208,192, 239,207,191, 239,206,189, 240,205,187, 241,205,186,
+    241,204,184, 242,203,183, 242,202,181, 242,201,180, 243,200,178, 243,199,177, 244,198,175, 244,197,173,
+    245,196,172, 245,194,170, 245,193,169, 245,192,167, 246,191,166, 246,190,164, 246,189,162, 247,188,161,
+    247,186,159, 247,185,158, 247,184,156, 247,183,155, 247,181,153, 247,180,151, 247,179,150, 247,177,148,
+    247,176,147, 247,175,145, 247,173,144, 247,172,142, 247,170,140, 247,169,139, 247,168,137, 247,166,136,
+    246,165,134, 246,163,133, 246,162,131, 245,160,129, 245,159,128, 245,157,126, 245,156,125, 244,154,123,
+    244,152,122, 243,151,120, 243,149,119, 243,148,117, 242,146,116, 242,144,114, 241,143,113, 241,141,111,
+    240,139,110, 240,138,108, 239,136,107, 238,134,105, 238,132,104, 237,131,102, 236,129,101, 236,127, 99,
+    235,125, 98, 234,123, 96, 233,122, 95, 233,120, 93, 232,118, 92, 231,116, 91, 230,114, 89, 229,112, 88,
+    228,110, 86, 227,108, 85, 227,107, 84, 226,105, 82, 225,103, 81, 224,101, 79, 223, 99, 78, 222, 97, 77,
+    221, 95, 75, 220, 93, 74, 218, 90, 73, 217, 88, 71, 216, 86, 70, 215, 84, 69, 214, 82, 68, 213, 80, 66,
+    212, 78, 65, 210, 75, 64, 209, 73, 63, 208, 71, 61, 207, 69, 60, 205, 66, 59, 204, 64, 58, 203, 62, 56,
+    202, 59, 55, 200, 56, 54, 199, 54, 53, 197, 51, 52, 196, 48, 50, 195, 46, 49, 193, 43, 48, 192, 40, 47,
+    190, 36, 46, 189, 31, 45, 187, 27, 44, 186, 22, 43, 184, 18, 42, 183, 13, 40, 181,  9, 39, 180,  4, 38}};
+
+}   // end namespace
+
+
+const uint8_t* r3dvis::colourMapTable( ColourMap cm)
+{
+    switch ( cm)
+    {
+        case ColourMap::VIRIDIS: return VIRIDIS.rgb;
+        case ColourMap::MAGMA: return MAGMA.rgb;
+        case ColourMap::CIVIDIS: return CIVIDIS.rgb;
+        case ColourMap::COOLWARM: return COOLWARM.rgb;
+    }   // end switch
+    return VIRIDIS.rgb;
+}   // end colourMapTable
+
+
+std::string r3dvis::colourMapName( ColourMap cm)
+{
+    switch ( cm)
+    {
+        case ColourMap::VIRIDIS: return "viridis";
+        case ColourMap::MAGMA: return "magma";
+        case ColourMap::CIVIDIS: return "cividis";
+        case ColourMap::COOLWARM: return "coolwarm";
+    }   // end switch
+    return "";
+}   // end colourMapName
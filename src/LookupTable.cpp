@@ -16,6 +16,10 @@
  ************************************************************************/
 
 #include <LookupTable.h>
+#include <SurfaceMapper.h>
+#include <RangeEstimator.h>
+#include <mutex>
+#include <map>
 using r3dvis::LookupTable;
 
 
@@ -36,6 +40,25 @@ LookupTable::LookupTable( const rimg::Colour &c0, const rimg::Colour &c1, const
 }   // end ctor
 
 
+LookupTable::LookupTable( ColourMap cm, size_t nc)
+{
+    setColours( cm, nc);
+}   // end ctor
+
+
+void LookupTable::setColours( ColourMap cm, size_t ncols)
+{
+    const int N = std::max<int>(2, int(ncols));
+    _cols.resize(N);
+    const uint8_t *tab = colourMapTable( cm);
+    for ( int i = 0; i < N; ++i)
+    {
+        const int j = int( double(i) * (COLOUR_MAP_SIZE-1) / (N-1) + 0.5);
+        _cols[i] = rimg::Colour( (int)tab[3*j], (int)tab[3*j+1], (int)tab[3*j+2]);
+    }   // end for
+}   // end setColours
+
+
 void LookupTable::setColours( const cv::Vec3b& c0, const cv::Vec3b& c1, size_t nc)
 {
     const vtkColor3ub v0( c0[0], c0[1], c0[2]);
@@ -121,3 +144,50 @@ vtkSmartPointer<vtkLookupTable> LookupTable::toVTK() const
     lut->Build();
     return lut;
 }   // end toVTK
+
+
+vtkSmartPointer<vtkLookupTable> LookupTable::toVTK( const Quantization &q, const cv::Vec3b &nanCol) const
+{
+    vtkSmartPointer<vtkLookupTable> lut = toVTK();
+    lut->SetTableRange( 0, q.nanLevel() - 1);
+    lut->SetAboveRangeColor( nanCol[0]/255.0, nanCol[1]/255.0, nanCol[2]/255.0, 1);
+    lut->UseAboveRangeColorOn();
+    lut->Build();   // Rebuild the special colours
+    return lut;
+}   // end toVTK
+
+
+vtkSmartPointer<vtkLookupTable> LookupTable::cachedCopyVTK( ColourMap cm, size_t ncols)
+{
+    static std::mutex lock;
+    static std::map<std::pair<ColourMap, size_t>, vtkSmartPointer<vtkLookupTable> > cache;
+    vtkSmartPointer<vtkLookupTable> lut = vtkSmartPointer<vtkLookupTable>::New();
+    std::lock_guard<std::mutex> guard( lock);
+    vtkSmartPointer<vtkLookupTable> &proto = cache[std::make_pair( cm, ncols)];
+    if ( !proto)
+        proto = LookupTable( cm, ncols).toVTK();
+    lut->DeepCopy( proto);  // Per caller so mappers can set their own ranges
+    return lut;
+}   // end cachedCopyVTK
+
+
+LookupTable LookupTable::equalised( const RangeEstimator &re, float lo, float hi, size_t ncols) const
+{
+    LookupTable lut;
+    if ( _cols.empty())
+        return lut;
+
+    const int N = std::max<int>(2, int(ncols));
+    const int M = int(_cols.size());
+    const double c0 = re.cdf( lo);
+    const double c1 = re.cdf( hi);
+    const double cr = c1 > c0 ? 1.0 / (c1 - c0) : 0.0;
+    lut._cols.resize(N);
+    for ( int j = 0; j < N; ++j)
+    {
+        const float v = lo + (hi - lo) * (j + 0.5f) / N;    // Value at the centre of colour j
+        const double f = std::min( std::max( (re.cdf(v) - c0) * cr, 0.0), 1.0);
+        lut._cols[j] = _cols[std::min( int(f * M), M-1)];
+    }   // end for
+    return lut;
+}   // end equalised
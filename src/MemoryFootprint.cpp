@@ -0,0 +1,227 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <MemoryFootprint.h>
+#include <VtkTools.h>
+#include <vtkActorCollection.h>
+#include <vtkCellArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkPolyData.h>
+#include <vtkProperty.h>
+#include <vtkTexture.h>
+#include <vtkMapper.h>
+#include <vtkPoints.h>
+#include <algorithm>
+#include <iomanip>
+using r3dvis::MemoryFootprint;
+using r3dvis::MemoryAccountant;
+
+
+namespace {
+
+// GetActualMemorySize returns kibibytes.
+size_t _bytes( vtkObject *obj)
+{
+    if ( vtkAbstractArray *arr = vtkAbstractArray::SafeDownCast( obj))
+        return size_t( arr->GetActualMemorySize()) * 1024;
+    if ( vtkCellArray *cells = vtkCellArray::SafeDownCast( obj))
+        return size_t( cells->GetActualMemorySize()) * 1024;
+    if ( vtkDataObject *data = vtkDataObject::SafeDownCast( obj))
+        return size_t( data->GetActualMemorySize()) * 1024;
+    return 0;
+}   // end _bytes
+
+}   // end namespace
+
+
+MemoryFootprint::MemoryFootprint()
+    : points(0), connectivity(0), pointData(0), cellData(0), fieldData(0), textures(0), other(0),
+      numActors(0), numPoints(0), numCells(0), numVertices(0) {}
+
+
+size_t MemoryFootprint::total() const
+{
+    return points + connectivity + pointData + cellData + fieldData + textures + other;
+}   // end total
+
+
+MemoryFootprint &MemoryFootprint::operator+=( const MemoryFootprint &fp)
+{
+    points += fp.points;
+    connectivity += fp.connectivity;
+    pointData += fp.pointData;
+    cellData += fp.cellData;
+    fieldData += fp.fieldData;
+    textures += fp.textures;
+    other += fp.other;
+    numActors += fp.numActors;
+    numPoints += fp.numPoints;
+    numCells += fp.numCells;
+    numVertices += fp.numVertices;
+    return *this;
+}   // end operator+=
+
+
+std::ostream &r3dvis::operator<<( std::ostream &os, const MemoryFootprint &fp)
+{
+    const auto mib = []( size_t b){ return double(b) / (1024*1024);};
+    const std::streamsize prec = os.precision();
+    os << std::fixed << std::setprecision(2)
+       << "Actors: " << fp.numActors << ", points: " << fp.numPoints << ", cells: " << fp.numCells;
+    if ( fp.numVertices > 0)
+        os << ", vertices: " << fp.numVertices << " (" << double(fp.numPoints) / fp.numVertices << " points per vertex)";
+    os << std::endl
+       << "  Points:       " << std::setw(10) << mib(fp.points) << " MiB" << std::endl
+       << "  Connectivity: " << std::setw(10) << mib(fp.connectivity) << " MiB" << std::endl
+       << "  Point data:   " << std::setw(10) << mib(fp.pointData) << " MiB" << std::endl
+       << "  Cell data:    " << std::setw(10) << mib(fp.cellData) << " MiB" << std::endl
+       << "  Field data:   " << std::setw(10) << mib(fp.fieldData) << " MiB" << std::endl
+       << "  Textures:     " << std::setw(10) << mib(fp.textures) << " MiB" << std::endl
+       << "  Other:        " << std::setw(10) << mib(fp.other) << " MiB" << std::endl
+       << "  Total:        " << std::setw(10) << mib(fp.total()) << " MiB" << std::endl;
+    os.precision( prec);
+    os.unsetf( std::ios_base::floatfield);
+    return os;
+}   // end operator<<
+
+
+bool MemoryAccountant::_first( const vtkObjectBase *obj) { return obj && _seen.insert( obj).second;}
+
+
+void MemoryAccountant::reset()
+{
+    _fp = MemoryFootprint();
+    _seen.clear();
+}   // end reset
+
+
+void MemoryAccountant::_addDataSet( vtkDataSet *ds)
+{
+    if ( !_first( ds))
+        return;
+
+    _fp.numPoints += size_t( ds->GetNumberOfPoints());
+    _fp.numCells += size_t( ds->GetNumberOfCells());
+    const size_t dsBytes = _bytes( ds);
+    size_t counted = 0;     // Bytes of ds accounted for in the categories (whether new or not)
+
+    const auto addArrays = [&]( vtkFieldData *fd, size_t &category)
+    {
+        if ( !fd)
+            return;
+        const int n = fd->GetNumberOfArrays();
+        for ( int i = 0; i < n; ++i)
+        {
+            vtkAbstractArray *arr = fd->GetAbstractArray(i);
+            const size_t b = _bytes( arr);
+            counted += b;
+            if ( _first( arr))
+                category += b;
+        }   // end for
+    };
+
+    if ( vtkPointSet *ps = vtkPointSet::SafeDownCast( ds))
+    {
+        vtkDataArray *pts = ps->GetPoints() ? ps->GetPoints()->GetData() : nullptr;
+        const size_t b = _bytes( pts);
+        counted += b;
+        if ( _first( pts))
+            _fp.points += b;
+    }   // end if
+
+    if ( vtkPolyData *pd = vtkPolyData::SafeDownCast( ds))
+    {
+        for ( vtkCellArray *cells : { pd->GetVerts(), pd->GetLines(), pd->GetPolys(), pd->GetStrips()})
+        {
+            const size_t b = _bytes( cells);
+            counted += b;
+            if ( _first( cells))
+                _fp.connectivity += b;
+        }   // end for
+    }   // end if
+
+    addArrays( ds->GetPointData(), _fp.pointData);
+    addArrays( ds->GetCellData(), _fp.cellData);
+    addArrays( ds->GetFieldData(), _fp.fieldData);
+
+    // Whatever the data set holds beyond its parts (cell links, cell type arrays etc).
+    if ( dsBytes > counted)
+        _fp.other += dsBytes - counted;
+
+    // Number of distinct vertices the points were made from.
+    vtkIntArray *pvmap = vtkIntArray::SafeDownCast( ds->GetFieldData()->GetAbstractArray( POINT_VERTEX_MAP));
+    if ( pvmap && pvmap->GetNumberOfTuples() > 0)
+    {
+        const int *vids = pvmap->GetPointer(0);
+        _fp.numVertices += size_t( *std::max_element( vids, vids + pvmap->GetNumberOfTuples())) + 1;
+    }   // end if
+}   // end _addDataSet
+
+
+void MemoryAccountant::_addTexture( vtkTexture *tx)
+{
+    if ( !tx || !_first( tx))
+        return;
+    vtkImageData *img = vtkImageData::SafeDownCast( tx->GetInput());
+    if ( _first( img))
+        _fp.textures += _bytes( img);
+}   // end _addTexture
+
+
+void MemoryAccountant::add( const vtkActor *cactor)
+{
+    vtkActor *actor = const_cast<vtkActor*>(cactor);
+    if ( !_first( actor))
+        return;
+    _fp.numActors++;
+
+    if ( vtkMapper *mapper = actor->GetMapper())
+        if ( vtkDataSet *ds = mapper->GetInputAsDataSet())
+            _addDataSet( ds);
+
+    _addTexture( actor->GetTexture());
+    for ( const auto &p : actor->GetProperty()->GetAllTextures())
+        _addTexture( p.second);
+}   // end add
+
+
+void MemoryAccountant::add( vtkRenderer *ren)
+{
+    vtkActorCollection *actors = ren->GetActors();
+    vtkCollectionSimpleIterator it;
+    actors->InitTraversal( it);
+    while ( vtkActor *actor = actors->GetNextActor( it))
+        add( actor);
+}   // end add
+
+
+MemoryFootprint r3dvis::memoryFootprint( const vtkActor *actor)
+{
+    MemoryAccountant acc;
+    acc.add( actor);
+    return acc.footprint();
+}   // end memoryFootprint
+
+
+MemoryFootprint r3dvis::memoryFootprint( vtkRenderer *ren)
+{
+    MemoryAccountant acc;
+    acc.add( ren);
+    return acc.footprint();
+}   // end memoryFootprint
@@ -0,0 +1,435 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <MeshBVH.h>
+#include <algorithm>
+#include <iostream>
+#include <future>
+#include <thread>
+#include <limits>
+#include <cassert>
+#include <cstring>
+using r3dvis::MeshBVH;
+using Vec3 = Eigen::Vector3f;
+using Array4 = Eigen::Array4f;
+
+
+namespace {
+
+const int NBINS = 16;
+const size_t LEAF_SIZE = 4;         // Must match the width of MeshBVH::Packet
+const size_t PARALLEL_MIN = 20000;  // Don't spawn threads to build subtrees smaller than this
+const int SAH_DEPTH = 48;          // Beyond this depth, split at the median to bound the tree depth
+const int STACK_SIZE = 96;         // Enough for SAH_DEPTH plus median splits of any realistic mesh
+const float INF = std::numeric_limits<float>::max();
+
+struct Box
+{
+    Box() : bmin( Vec3::Constant(INF)), bmax( Vec3::Constant(-INF)) {}
+    void add( const Vec3 &p) { bmin = bmin.cwiseMin(p); bmax = bmax.cwiseMax(p);}
+    void add( const Box &b) { bmin = bmin.cwiseMin(b.bmin); bmax = bmax.cwiseMax(b.bmax);}
+    float area() const
+    {
+        if ( bmin[0] > bmax[0])
+            return 0;
+        const Vec3 d = bmax - bmin;
+        return 2.0f * (d[0]*d[1] + d[1]*d[2] + d[2]*d[0]);
+    }   // end area
+    Vec3 bmin, bmax;
+};  // end struct
+
+
+struct BuildTri
+{
+    Box box;
+    Vec3 c;     // Centroid
+    int fid;
+};  // end struct
+
+
+struct BuildNode
+{
+    Box box;
+    std::unique_ptr<BuildNode> left, right;
+    size_t begin, end;  // Range of triangles if a leaf
+};  // end struct
+
+
+// Find the best binned SAH split of tris[begin,end) returning false if no split is possible
+// (all centroids coincide). On true return, axis and pos give the splitting plane.
+bool findSplit( const std::vector<BuildTri> &tris, size_t begin, size_t end, int &axis, float &pos)
+{
+    Box cbox;
+    for ( size_t i = begin; i < end; ++i)
+        cbox.add( tris[i].c);
+
+    float bestCost = INF;
+    axis = -1;
+    for ( int a = 0; a < 3; ++a)
+    {
+        const float lo = cbox.bmin[a];
+        const float ext = cbox.bmax[a] - lo;
+        if ( ext <= 0)
+            continue;
+        const float scale = NBINS / ext;
+
+        Box bins[NBINS];
+        size_t counts[NBINS] = {0};
+        for ( size_t i = begin; i < end; ++i)
+        {
+            const int b = std::min( NBINS-1, int((tris[i].c[a] - lo) * scale));
+            bins[b].add( tris[i].box);
+            counts[b]++;
+        }   // end for
+
+        // Sweep from the right to get the right side areas and counts for each plane.
+        float rarea[NBINS];
+        size_t rcount[NBINS];
+        Box rb;
+        size_t rc = 0;
+        for ( int b = NBINS-1; b > 0; --b)
+        {
+            rb.add( bins[b]);
+            rc += counts[b];
+            rarea[b] = rb.area();
+            rcount[b] = rc;
+        }   // end for
+
+        Box lb;
+        size_t lc = 0;
+        for ( int b = 1; b < NBINS; ++b)   // Plane between bins b-1 and b
+        {
+            lb.add( bins[b-1]);
+            lc += counts[b-1];
+            if ( lc == 0 || rcount[b] == 0)
+                continue;
+            const float cost = lc * lb.area() + rcount[b] * rarea[b];
+            if ( cost < bestCost)
+            {
+                bestCost = cost;
+                axis = a;
+                pos = lo + b / scale;
+            }   // end if
+        }   // end for
+    }   // end for
+
+    return axis >= 0;
+}   // end findSplit
+
+
+std::unique_ptr<BuildNode> build( std::vector<BuildTri> &tris, size_t begin, size_t end, int depth, int parDepth)
+{
+    std::unique_ptr<BuildNode> node( new BuildNode);
+    node->begin = begin;
+    node->end = end;
+    for ( size_t i = begin; i < end; ++i)
+        node->box.add( tris[i].box);
+
+    const size_t n = end - begin;
+    if ( n <= LEAF_SIZE)
+        return node;
+
+    size_t mid;
+    int axis;
+    float pos;
+    if ( depth < SAH_DEPTH && findSplit( tris, begin, end, axis, pos))
+    {
+        auto it = std::partition( tris.begin() + begin, tris.begin() + end,
+                                  [=]( const BuildTri &t){ return t.c[axis] < pos;});
+        mid = size_t( it - tris.begin());
+        if ( mid == begin || mid == end)    // Can happen from rounding at bin edges
+            mid = begin + n/2;
+    }   // end if
+    else    // Coincident centroids (or too deep) so just halve
+        mid = begin + n/2;
+
+    if ( parDepth > 0 && n >= PARALLEL_MIN)
+    {
+        // Children work on disjoint ranges so can be built concurrently.
+        std::future<std::unique_ptr<BuildNode> > lfut = std::async( std::launch::async,
+                [&tris, begin, mid, depth, parDepth](){ return build( tris, begin, mid, depth+1, parDepth-1);});
+        node->right = build( tris, mid, end, depth+1, parDepth-1);
+        node->left = lfut.get();
+    }   // end if
+    else
+    {
+        node->left = build( tris, begin, mid, depth+1, 0);
+        node->right = build( tris, mid, end, depth+1, 0);
+    }   // end else
+
+    return node;
+}   // end build
+
+
+int flatten( const BuildNode &bn, const std::vector<BuildTri> &tris, const r3d::Mesh &mesh,
+             std::vector<MeshBVH::Node> &nodes, std::vector<MeshBVH::Packet> &packets)
+{
+    const int idx = int(nodes.size());
+    nodes.emplace_back();
+    for ( int k = 0; k < 3; ++k)
+    {
+        nodes[idx].bmin[k] = bn.box.bmin[k];
+        nodes[idx].bmax[k] = bn.box.bmax[k];
+    }   // end for
+
+    if ( !bn.left)  // Leaf
+    {
+        MeshBVH::Packet pk;
+        memset( &pk, 0, sizeof(MeshBVH::Packet));
+        int j = 0;
+        for ( size_t i = bn.begin; i < bn.end; ++i, ++j)
+        {
+            const int fid = tris[i].fid;
+            const int *fvidxs = mesh.fvidxs(fid);
+            const Vec3 &v0 = mesh.uvtx(fvidxs[0]);
+            const Vec3 e1 = mesh.uvtx(fvidxs[1]) - v0;
+            const Vec3 e2 = mesh.uvtx(fvidxs[2]) - v0;
+            for ( int k = 0; k < 3; ++k)
+            {
+                pk.v0[k][j] = v0[k];
+                pk.e1[k][j] = e1[k];
+                pk.e2[k][j] = e2[k];
+            }   // end for
+            pk.fid[j] = fid;
+        }   // end for
+        for ( ; j < 4; ++j)
+            pk.fid[j] = -1;
+        nodes[idx].index = int(packets.size());
+        nodes[idx].count = int(bn.end - bn.begin);
+        packets.push_back( pk);
+    }   // end if
+    else
+    {
+        flatten( *bn.left, tris, mesh, nodes, packets);  // Left child is always idx+1
+        const int ridx = flatten( *bn.right, tris, mesh, nodes, packets);
+        nodes[idx].index = ridx;
+        nodes[idx].count = 0;
+    }   // end else
+
+    return idx;
+}   // end flatten
+
+
+size_t numThreads( size_t n)
+{
+    if ( n == 0)
+        n = std::thread::hardware_concurrency();
+    return std::max<size_t>( n, 1);
+}   // end numThreads
+
+}   // end namespace
+
+
+MeshBVH::Ptr MeshBVH::create( const r3d::Mesh &mesh, size_t nthreads)
+{
+    return Ptr( new MeshBVH( mesh, nthreads));
+}   // end create
+
+
+MeshBVH::MeshBVH( const r3d::Mesh &mesh, size_t nthreads) : _nfaces(0)
+{
+    setTransform( mesh.transformMatrix());
+    if ( !mesh.hasSequentialIds())
+    {
+        std::cerr << "[ERROR] r3dvis::MeshBVH: Mesh IDs must be in sequential order!" << std::endl;
+        return;
+    }   // end if
+
+    _nfaces = mesh.numFaces();
+    if ( _nfaces == 0)
+        return;
+
+    std::vector<BuildTri> tris( _nfaces);
+    for ( int fid = 0; fid < int(_nfaces); ++fid)
+    {
+        const int *fvidxs = mesh.fvidxs(fid);
+        BuildTri &t = tris[fid];
+        t.box.add( mesh.uvtx(fvidxs[0]));
+        t.box.add( mesh.uvtx(fvidxs[1]));
+        t.box.add( mesh.uvtx(fvidxs[2]));
+        t.c = 0.5f * (t.box.bmin + t.box.bmax);
+        t.fid = fid;
+    }   // end for
+
+    // Spawn a thread for each left subtree down to a depth giving about nthreads subtrees.
+    int parDepth = 0;
+    while ( (size_t(1) << parDepth) < numThreads( nthreads))
+        parDepth++;
+    std::unique_ptr<BuildNode> root = build( tris, 0, _nfaces, 0, parDepth);
+
+    _nodes.reserve( 2*_nfaces/LEAF_SIZE + 1);
+    _packets.reserve( _nfaces/2 + 1);
+    flatten( *root, tris, mesh, _nodes, _packets);
+}   // end ctor
+
+
+void MeshBVH::setTransform( const r3d::Mat4f &T)
+{
+    _T = T;
+    _iT = T.inverse();
+}   // end setTransform
+
+
+bool MeshBVH::_intersectModel( const Vec3 &o, const Vec3 &d, float tmin,
+                               float &tbest, int &fid, float &bu, float &bv) const
+{
+    if ( _nodes.empty())
+        return false;
+
+    const Vec3 invd( 1.0f/d[0], 1.0f/d[1], 1.0f/d[2]);
+    const bool neg[3] = { invd[0] < 0, invd[1] < 0, invd[2] < 0};
+
+    // Ray broadcast to all lanes
+    const Array4 ox = Array4::Constant(o[0]), oy = Array4::Constant(o[1]), oz = Array4::Constant(o[2]);
+    const Array4 dx = Array4::Constant(d[0]), dy = Array4::Constant(d[1]), dz = Array4::Constant(d[2]);
+
+    bool found = false;
+    int stack[STACK_SIZE];
+    int sp = 0;
+    stack[sp++] = 0;
+    while ( sp > 0)
+    {
+        const Node &node = _nodes[stack[--sp]];
+
+        // Slab test
+        float t0 = tmin;
+        float t1 = tbest;
+        for ( int k = 0; k < 3; ++k)
+        {
+            float tn = (node.bmin[k] - o[k]) * invd[k];
+            float tf = (node.bmax[k] - o[k]) * invd[k];
+            if ( neg[k])
+                std::swap( tn, tf);
+            t0 = std::max( t0, tn);
+            t1 = std::min( t1, tf);
+        }   // end for
+        if ( t0 > t1)
+            continue;
+
+        if ( node.count == 0)
+        {
+            const int lidx = int(&node - &_nodes[0]) + 1;
+            const int ridx = node.index;
+            // Visit the nearer child first (pushed last).
+            const Node &ln = _nodes[lidx];
+            const Node &rn = _nodes[ridx];
+            int axis = 0;
+            float best = -1;
+            for ( int k = 0; k < 3; ++k)
+            {
+                const float sep = fabsf( (ln.bmin[k] + ln.bmax[k]) - (rn.bmin[k] + rn.bmax[k]));
+                if ( sep > best)
+                {
+                    best = sep;
+                    axis = k;
+                }   // end if
+            }   // end for
+            const bool leftFirst = ((ln.bmin[axis] + ln.bmax[axis]) < (rn.bmin[axis] + rn.bmax[axis])) != neg[axis];
+            assert( sp + 2 <= STACK_SIZE);
+            stack[sp++] = leftFirst ? ridx : lidx;
+            stack[sp++] = leftFirst ? lidx : ridx;
+            continue;
+        }   // end if
+
+        // Moller-Trumbore against all four triangles of the leaf at once.
+        const Packet &pk = _packets[node.index];
+        const Eigen::Map<const Array4> v0x(pk.v0[0]), v0y(pk.v0[1]), v0z(pk.v0[2]);
+        const Eigen::Map<const Array4> e1x(pk.e1[0]), e1y(pk.e1[1]), e1z(pk.e1[2]);
+        const Eigen::Map<const Array4> e2x(pk.e2[0]), e2y(pk.e2[1]), e2z(pk.e2[2]);
+
+        const Array4 px = dy*e2z - dz*e2y;
+        const Array4 py = dz*e2x - dx*e2z;
+        const Array4 pz = dx*e2y - dy*e2x;
+        const Array4 det = e1x*px + e1y*py + e1z*pz;
+        const Array4 idet = det.inverse();
+        const Array4 tx = ox - v0x;
+        const Array4 ty = oy - v0y;
+        const Array4 tz = oz - v0z;
+        const Array4 u = (tx*px + ty*py + tz*pz) * idet;
+        const Array4 qx = ty*e1z - tz*e1y;
+        const Array4 qy = tz*e1x - tx*e1z;
+        const Array4 qz = tx*e1y - ty*e1x;
+        const Array4 v = (dx*qx + dy*qy + dz*qz) * idet;
+        const Array4 t = (e2x*qx + e2y*qy + e2z*qz) * idet;
+
+        const Eigen::Array<bool,4,1> hit = (det.abs() > 1e-12f) && (u >= 0) && (v >= 0) && (u + v <= 1) && (t >= tmin) && (t < tbest);
+        for ( int j = 0; j < node.count; ++j)
+        {
+            if ( hit[j] && t[j] < tbest)
+            {
+                tbest = t[j];
+                fid = pk.fid[j];
+                bu = u[j];
+                bv = v[j];
+                found = true;
+            }   // end if
+        }   // end for
+    }   // end while
+
+    return found;
+}   // end _intersectModel
+
+
+bool MeshBVH::intersect( const r3d::Vec3f &origin, const r3d::Vec3f &dir, Hit &hit, float tmin) const
+{
+    hit = Hit();
+    const float len = dir.norm();
+    if ( len <= 0)
+        return false;
+    const Vec3 wd = dir / len;  // Unit length so t is the world distance
+
+    // Transform the ray into mesh space. The ray parameter is unchanged by the (affine) transform.
+    const Vec3 o = (_iT * origin.homogeneous()).hnormalized();
+    const Vec3 d = _iT.block<3,3>(0,0) * wd;
+
+    float tbest = INF;
+    if ( !_intersectModel( o, d, tmin, tbest, hit.fid, hit.u, hit.v))
+        return false;
+    hit.t = tbest;
+    hit.pos = origin + tbest * wd;
+    return true;
+}   // end intersect
+
+
+size_t MeshBVH::intersect( const std::vector<r3d::Vec3f> &origins, const std::vector<r3d::Vec3f> &dirs,
+                           std::vector<Hit> &hits, size_t nthreads) const
+{
+    assert( origins.size() == dirs.size());
+    const size_t n = std::min( origins.size(), dirs.size());
+    hits.resize(n);
+
+    const size_t nt = std::min( numThreads( nthreads), std::max<size_t>( 1, n / 256));
+    std::vector<std::future<size_t> > futs;
+    const size_t chunk = (n + nt - 1) / nt;
+    for ( size_t i = 0; i < n; i += chunk)
+    {
+        const size_t j = std::min( n, i + chunk);
+        futs.push_back( std::async( nt > 1 ? std::launch::async : std::launch::deferred, [&, i, j]()
+        {
+            size_t nhits = 0;
+            for ( size_t k = i; k < j; ++k)
+                if ( intersect( origins[k], dirs[k], hits[k]))
+                    nhits++;
+            return nhits;
+        }));
+    }   // end for
+
+    size_t nhits = 0;
+    for ( std::future<size_t> &f : futs)
+        nhits += f.get();
+    return nhits;
+}   // end intersect
@@ -18,13 +18,17 @@
 #include <OffscreenMeshViewer.h>
 #include <VtkActorCreator.h>
 #include <VtkTools.h>
+#include <algorithm>
+#include <cmath>
 using r3dvis::OffscreenMeshViewer;
+using r3dvis::CaptureTimer;
+using r3dvis::RenderTimer;
 using r3dvis::byte;
 using r3d::CameraParams;
 
 
 OffscreenMeshViewer::OffscreenMeshViewer( const cv::Size& dims, float rng)
-    : _actor(nullptr), _picker(nullptr)
+    : _actor(nullptr), _picker(nullptr), _resetClipping(true)
 {
     _viewer = Viewer::create(true/*offscreen*/);
     _viewer->renderer()->UseFXAAOn();
@@ -47,30 +51,36 @@ OffscreenMeshViewer::~OffscreenMeshViewer()
 
 void OffscreenMeshViewer::setBackgroundColour( double r, double g, double b)
 {
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::setBackgroundColour", _viewer->renderer());
     _viewer->renderer()->SetBackground(r,g,b);
 }   // end setBackgroundColour
 
 
 void OffscreenMeshViewer::setSize( const cv::Size& dims)
 {
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::setSize", _viewer->renderer());
     _viewer->setSize( static_cast<size_t>(dims.width), static_cast<size_t>(dims.height));
-    setCamera( _viewer->camera());  // Refresh
+    _resetClipping = true;
 }   // end setSize
 
 
 void OffscreenMeshViewer::clear()
 {
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::clear", _viewer->renderer());
     if ( _actor)
     {
         _viewer->removeActor(_actor);
         _actor = nullptr;
-        setCamera( _viewer->camera());  // Refresh
+        if ( _picker)
+            _picker->clearLocators();
+        _resetClipping = true;
     }   // end if
 }   // end clear
 
 
 vtkActor* OffscreenMeshViewer::setModel( const r3d::Mesh& model)
 {
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::setModel", _viewer->renderer());
     vtkSmartPointer<vtkActor> actor = VtkActorCreator::generateActor( model);
     setActor(actor);
     return _actor;
@@ -79,15 +89,17 @@ vtkActor* OffscreenMeshViewer::setModel( const r3d::Mesh& model)
 
 void OffscreenMeshViewer::setActor( vtkSmartPointer<vtkActor> actor)
 {
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::setActor", _viewer->renderer());
     clear();
     _actor = actor;
     _viewer->addActor( _actor);
-    setCamera(_viewer->camera());   // Refresh
+    _resetClipping = true;
 }   // end setActor
 
 
 void OffscreenMeshViewer::setModelColour( double r, double g, double b)
 {
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::setModelColour", _viewer->renderer());
     assert(_actor);
     if ( _actor)
         _actor->GetProperty()->SetColor( r, g, b);
@@ -96,44 +108,229 @@ void OffscreenMeshViewer::setModelColour( double r, double g, double b)
 
 void OffscreenMeshViewer::setCamera( const CameraParams& cp)
 {
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::setCamera", _viewer->renderer());
     _viewer->setCamera( cp);
-    _viewer->resetClippingRange();
-    _viewer->updateRender();
+    _resetClipping = true;
 }   // end setCamera
 
 
-cv::Mat_<cv::Vec3b> OffscreenMeshViewer::snapshot() const { return _viewer->extractBGR();}
+void OffscreenMeshViewer::_resetClippingIfNeeded() const
+{
+    if ( _resetClipping)
+    {
+        _viewer->resetClippingRange();
+        _resetClipping = false;
+    }   // end if
+}   // end _resetClippingIfNeeded
+
+
+bool OffscreenMeshViewer::render() const
+{
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::render", _viewer->renderer());
+    _resetClippingIfNeeded();
+    return _viewer->renderIfDirty();
+}   // end render
+
+
+cv::Mat_<cv::Vec3b> OffscreenMeshViewer::snapshot() const
+{
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::snapshot", _viewer->renderer());
+    render();
+    return _viewer->extractBGR();
+}   // end snapshot
+
+
+bool OffscreenMeshViewer::snapshot( cv::Mat_<cv::Vec3b> &dst) const
+{
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::snapshot", _viewer->renderer());
+    render();
+    CaptureTimer ctimer( &_viewer->stats());
+    return readBGR( _viewer->renderer(), dst);
+}   // end snapshot
 
 
 cv::Mat_<byte> OffscreenMeshViewer::lightnessSnapshot() const
 {
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::lightnessSnapshot", _viewer->renderer());
     return contrastStretch( getLightness( snapshot(), 255, CV_8U));
 }   // end lightnessSnapshot
 
 
+namespace {
+
+// Choose the smaller of the forward and backward differences so normals aren't
+// smeared across depth discontinuities at silhouettes.
+bool _pickDiff( const cv::Mat_<cv::Vec3f> &cpos, const cv::Mat_<byte> &mask,
+                int r0, int c0, int r1, int c1, int r2, int c2, cv::Vec3f &d)
+{
+    const cv::Size sz = cpos.size();
+    const bool fok = r1 >= 0 && c1 >= 0 && r1 < sz.height && c1 < sz.width && mask(r1,c1);
+    const bool bok = r2 >= 0 && c2 >= 0 && r2 < sz.height && c2 < sz.width && mask(r2,c2);
+    if ( !fok && !bok)
+        return false;
+    const cv::Vec3f fd = fok ? cv::Vec3f(cpos(r1,c1) - cpos(r0,c0)) : cv::Vec3f();
+    const cv::Vec3f bd = bok ? cv::Vec3f(cpos(r0,c0) - cpos(r2,c2)) : cv::Vec3f();
+    if ( fok && bok)
+        d = fabsf(fd[2]) <= fabsf(bd[2]) ? fd : bd;
+    else
+        d = fok ? fd : bd;
+    return true;
+}   // end _pickDiff
+
+}   // end namespace
+
+
+OffscreenMeshViewer::GBuffer OffscreenMeshViewer::gbuffer() const
+{
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::gbuffer", _viewer->renderer());
+    render();
+    vtkRenderer *ren = _viewer->renderer();
+
+    GBuffer gb;
+    cv::Mat_<float> zimg;
+    {
+        CaptureTimer ctimer( &_viewer->stats());
+        gb.bgr = readBGR( ren);
+        zimg = readZ( ren);
+    }   // end capture
+    const int h = zimg.rows;
+    const int w = zimg.cols;
+    gb.mask = zimg < 1.0f;
+    gb.positions = cv::Mat_<cv::Vec3f>::zeros( h, w);
+    gb.normals = cv::Mat_<cv::Vec3f>::zeros( h, w);
+    gb.depth = cv::Mat_<float>::zeros( h, w);
+    cv::Mat_<cv::Vec3f> cpos = cv::Mat_<cv::Vec3f>::zeros( h, w);   // Camera space positions
+
+    const Eigen::Matrix4d pinv = compositeProjection( ren).inverse();
+    const Eigen::Matrix4d vmat = toEigen( ren->GetActiveCamera()->GetViewTransformMatrix()).cast<double>();
+
+    // Unproject a row at a time into world then camera space.
+    Eigen::Matrix<double, 4, Eigen::Dynamic> vpts( 4, w);
+    vpts.row(3).setOnes();
+    for ( int j = 0; j < w; ++j)
+        vpts(0,j) = 2.0 * (j + 0.5) / w - 1.0;
+    for ( int i = 0; i < h; ++i)
+    {
+        vpts.row(1).setConstant( 2.0 * (h - i - 0.5) / h - 1.0);
+        for ( int j = 0; j < w; ++j)
+            vpts(2,j) = zimg(i,j);
+        Eigen::Matrix<double, 4, Eigen::Dynamic> wpts = pinv * vpts;
+        const Eigen::Array<double, 1, Eigen::Dynamic> iw = wpts.row(3).array().inverse();
+        wpts.array().rowwise() *= iw;
+        const Eigen::Matrix<double, 4, Eigen::Dynamic> cpts = vmat * wpts;
+
+        const byte *mrow = gb.mask.ptr<byte>(i);
+        cv::Vec3f *prow = gb.positions.ptr<cv::Vec3f>(i);
+        cv::Vec3f *crow = cpos.ptr<cv::Vec3f>(i);
+        float *drow = gb.depth.ptr<float>(i);
+        for ( int j = 0; j < w; ++j)
+        {
+            if ( !mrow[j])
+                continue;
+            prow[j] = cv::Vec3f( float(wpts(0,j)), float(wpts(1,j)), float(wpts(2,j)));
+            crow[j] = cv::Vec3f( float(cpts(0,j)), float(cpts(1,j)), float(cpts(2,j)));
+            drow[j] = -crow[j][2];  // Camera looks down its negative Z axis
+        }   // end for
+    }   // end for
+
+    cv::Vec3f dx, dy;
+    for ( int i = 0; i < h; ++i)
+    {
+        const byte *mrow = gb.mask.ptr<byte>(i);
+        cv::Vec3f *nrow = gb.normals.ptr<cv::Vec3f>(i);
+        for ( int j = 0; j < w; ++j)
+        {
+            if ( !mrow[j] || !_pickDiff( cpos, gb.mask, i, j, i, j+1, i, j-1, dx)
+                          || !_pickDiff( cpos, gb.mask, i, j, i-1, j, i+1, j, dy))
+                continue;
+            cv::Vec3f n = dx.cross(dy);
+            const float len = float(cv::norm(n));
+            if ( len <= 0)
+                continue;
+            n /= len;
+            if ( n.dot( cpos(i,j)) > 0)   // Face the camera
+                n = -n;
+            nrow[j] = n;
+        }   // end for
+    }   // end for
+
+    return gb;
+}   // end gbuffer
+
+
+cv::Mat_<int> OffscreenMeshViewer::faceIds( cv::Mat_<int> *propIds, std::vector<const vtkProp*> *props) const
+{
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::faceIds", _viewer->renderer());
+    _resetClippingIfNeeded();   // The selector does the rendering
+    IdBuffer ibuf = _viewer->extractIds();
+
+    // Only the model's faces are wanted in the returned map.
+    const auto it = std::find( ibuf.props.begin(), ibuf.props.end(), _actor.Get());
+    const int aidx = it != ibuf.props.end() ? int(it - ibuf.props.begin()) : -1;
+    cv::Mat_<int> fids = ibuf.cellIds.clone();
+    fids.setTo( -1, ibuf.propIds != aidx);
+
+    if ( propIds)
+        *propIds = ibuf.propIds;
+    if ( props)
+        *props = ibuf.props;
+    return fids;
+}   // end faceIds
+
+
 bool OffscreenMeshViewer::pick( const cv::Point2f& p) const
 {
-    return picker()->pickActor(p) != nullptr;
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::pick", _viewer->renderer());
+    render();
+    return picker()->pickActor(p) != nullptr;  // Leaves the viewer dirty
 }   // end pick
 
 
 r3d::Vec3f OffscreenMeshViewer::worldPosition( const cv::Point2f& p) const
 {
-    return picker()->pickPosition(p);
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::worldPosition", _viewer->renderer());
+    render();
+    return picker()->pickPosition(p);  // Leaves the viewer dirty
 }   // end worldPosition
 
 
+size_t OffscreenMeshViewer::worldPositions( const std::vector<cv::Point2f> &ps, std::vector<r3d::Vec3f> &vs, std::vector<bool> &hits) const
+{
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::worldPositions", _viewer->renderer());
+    render();
+    return picker()->pickPositions( ps, vs, hits);
+}   // end worldPositions
+
+
 cv::Point2f OffscreenMeshViewer::imagePlane( const r3d::Vec3f& v) const
 {
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::imagePlane", _viewer->renderer());
+    render();
     const cv::Size sz = _viewer->size();
     cv::Point p = picker()->projectToImagePlane(v);
     return cv::Point2f( float(p.x)/sz.width, float(p.y)/sz.height);
 }   // end imagePlane
 
 
+void OffscreenMeshViewer::imagePlane( const std::vector<r3d::Vec3f> &vs, std::vector<cv::Point2f> &ps, std::vector<bool> *occluded) const
+{
+    RenderTimer timer( &_viewer->stats(), "OffscreenMeshViewer::imagePlane", _viewer->renderer());
+    render();
+    const cv::Size sz = _viewer->size();
+    std::vector<cv::Point> pxls;
+    picker()->projectToImagePlane( vs, pxls, occluded);
+    ps.resize( pxls.size());
+    for ( size_t i = 0; i < pxls.size(); ++i)
+        ps[i] = cv::Point2f( float(pxls[i].x)/sz.width, float(pxls[i].y)/sz.height);
+}   // end imagePlane
+
+
 r3dvis::RendererPicker* OffscreenMeshViewer::picker() const
 {
     if ( !_picker)
+    {
         _picker = new RendererPicker( _viewer->renderer(), RendererPicker::TOP_LEFT);
+        _picker->setStats( &_viewer->stats());
+    }   // end if
     return _picker;
 }   // end picker
@@ -0,0 +1,192 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <OffscreenMeshViewerPool.h>
+#include <VtkActorCreator.h>
+#include <stdexcept>
+#include <iostream>
+#include <cassert>
+using r3dvis::OffscreenMeshViewerPool;
+using r3dvis::OffscreenMeshViewer;
+using MeshCPtr = std::shared_ptr<const r3d::Mesh>;
+
+
+OffscreenMeshViewerPool::Options::Options()
+    : dims(512,512), bgColour(0,0,0), setModelColour(false), modelColour(1,1,1), reuseActor(true)
+{}  // end ctor
+
+
+OffscreenMeshViewerPool::Ptr OffscreenMeshViewerPool::create( size_t nworkers)
+{
+    return Ptr( new OffscreenMeshViewerPool( nworkers));
+}   // end create
+
+
+OffscreenMeshViewerPool::OffscreenMeshViewerPool( size_t nworkers) : _stopping(false)
+{
+    if ( nworkers == 0)
+        nworkers = std::max<size_t>( 1, std::thread::hardware_concurrency());
+    _workers.reserve( nworkers);
+    for ( size_t i = 0; i < nworkers; ++i)
+        _workers.emplace_back( [this](){ _run();});
+}   // end ctor
+
+
+OffscreenMeshViewerPool::~OffscreenMeshViewerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stopping = true;
+    }
+    _cv.notify_all();
+    for ( std::thread &t : _workers)
+        t.join();
+}   // end dtor
+
+
+size_t OffscreenMeshViewerPool::pending() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _jobs.size();
+}   // end pending
+
+
+void OffscreenMeshViewerPool::_enqueue( Job &&job)
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _jobs.push_back( std::move(job));
+    }
+    _cv.notify_one();
+}   // end _enqueue
+
+
+void OffscreenMeshViewerPool::_run()
+{
+    // The viewer (and its render window) must be created and used only by
+    // this thread so that each worker has its own rendering context.
+    std::unique_ptr<OffscreenMeshViewer> viewer;
+    std::weak_ptr<const r3d::Mesh> lastMesh;
+    while ( true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _cv.wait( lock, [this](){ return _stopping || !_jobs.empty();});
+            if ( _jobs.empty()) // Only true if stopping
+                break;
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        // Jobs pass their own exceptions to their futures but viewer creation
+        // can also throw in which case the job is dropped (its future gets a
+        // broken promise) rather than taking down the worker.
+        try
+        {
+            if ( !viewer)
+                viewer.reset( new OffscreenMeshViewer( cv::Size(512,512)));
+            job( *viewer, lastMesh);
+        }   // end try
+        catch ( const std::exception &e)
+        {
+            std::cerr << "[ERROR] r3dvis::OffscreenMeshViewerPool::_run: " << e.what() << std::endl;
+        }   // end catch
+    }   // end while
+}   // end _run
+
+
+namespace {
+
+OffscreenMeshViewerPool::Snapshots takeSnapshots( OffscreenMeshViewer &viewer,
+                                                  std::weak_ptr<const r3d::Mesh> &lastMesh,
+                                                  const MeshCPtr &mesh,
+                                                  const std::vector<r3d::CameraParams> &cams,
+                                                  const OffscreenMeshViewerPool::Options &opts)
+{
+    OffscreenMeshViewerPool::Snapshots snaps;
+    if ( !opts.reuseActor || lastMesh.lock() != mesh)
+    {
+        lastMesh.reset();
+        viewer.clear();
+        vtkSmartPointer<vtkActor> actor = r3dvis::VtkActorCreator::generateActor( *mesh);
+        if ( !actor)    // Reported through the job's future
+            throw std::runtime_error( "r3dvis::OffscreenMeshViewerPool: Unable to create actor from mesh!");
+        viewer.setActor( actor);
+        lastMesh = mesh;
+    }   // end if
+
+    viewer.setSize( opts.dims);
+    viewer.setBackgroundColour( opts.bgColour[0], opts.bgColour[1], opts.bgColour[2]);
+    // Always set the colour since a reused actor keeps the colour from the worker's previous job.
+    const cv::Vec3d mcol = opts.setModelColour ? opts.modelColour : cv::Vec3d(1,1,1);  // VTK's default
+    viewer.setModelColour( mcol[0], mcol[1], mcol[2]);
+
+    snaps.reserve( cams.size());
+    for ( const r3d::CameraParams &cam : cams)
+    {
+        viewer.setCamera( cam);
+        snaps.push_back( viewer.snapshot());
+    }   // end for
+    return snaps;
+}   // end takeSnapshots
+
+}   // end namespace
+
+
+std::future<OffscreenMeshViewerPool::Snapshots>
+OffscreenMeshViewerPool::submit( const MeshCPtr &mesh, const std::vector<r3d::CameraParams> &cams, const Options &opts)
+{
+    assert( mesh);
+    // std::function must be copyable so the (move only) promise is shared.
+    auto prom = std::make_shared<std::promise<Snapshots> >();
+    std::future<Snapshots> fut = prom->get_future();
+    _enqueue( [=]( OffscreenMeshViewer &viewer, std::weak_ptr<const r3d::Mesh> &lastMesh)
+    {
+        try
+        {
+            prom->set_value( takeSnapshots( viewer, lastMesh, mesh, cams, opts));
+        }   // end try
+        catch (...)
+        {
+            lastMesh.reset();   // Viewer state unknown so don't reuse its actor
+            prom->set_exception( std::current_exception());
+        }   // end catch
+    });
+    return fut;
+}   // end submit
+
+
+std::future<void> OffscreenMeshViewerPool::submit( const std::function<void( OffscreenMeshViewer&)> &fn)
+{
+    auto prom = std::make_shared<std::promise<void> >();
+    std::future<void> fut = prom->get_future();
+    _enqueue( [=]( OffscreenMeshViewer &viewer, std::weak_ptr<const r3d::Mesh> &lastMesh)
+    {
+        lastMesh.reset();   // Can't know what the job does to the viewer's actor
+        try
+        {
+            fn( viewer);
+            prom->set_value();
+        }   // end try
+        catch (...)
+        {
+            prom->set_exception( std::current_exception());
+        }   // end catch
+    });
+    return fut;
+}   // end submit
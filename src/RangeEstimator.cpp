@@ -0,0 +1,284 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <RangeEstimator.h>
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <limits>
+#include <cassert>
+#include <cmath>
+using r3dvis::RangeEstimator;
+
+
+namespace {
+const size_t NPENDING = 1024;   // Values seen before fixing the initial histogram range
+const size_t MIN_PER_THREAD = 65536;
+}   // end namespace
+
+
+RangeEstimator::RangeEstimator( size_t nbins)
+    : _nbins(16), _lo(0), _width(0), _count(0), _nonFinite(0),
+      _min( std::numeric_limits<float>::max()), _max( -std::numeric_limits<float>::max())
+{
+    while ( _nbins < nbins)
+        _nbins *= 2;
+    _pending.reserve( NPENDING);
+}   // end ctor
+
+
+void RangeEstimator::add( float v)
+{
+    if ( !std::isfinite(v))
+    {
+        _nonFinite++;
+        return;
+    }   // end if
+
+    _count++;
+    _min = std::min( _min, v);
+    _max = std::max( _max, v);
+    if ( _bins.empty())
+    {
+        _pending.push_back(v);
+        if ( _pending.size() >= NPENDING)
+            _init();
+    }   // end if
+    else
+        _bin(v);
+}   // end add
+
+
+void RangeEstimator::add( const float *vals, size_t n, size_t stride)
+{
+    for ( size_t i = 0; i < n; ++i)
+        add( vals[i*stride]);
+}   // end add
+
+
+void RangeEstimator::_init()
+{
+    // Set the initial range from the pending values with a bit of margin.
+    _bins.assign( _nbins, 0);
+    const double ext = std::max( double(_max) - double(_min), std::max( 1e-6, 1e-6 * fabs(_min)));
+    _width = 1.25 * ext / _nbins;
+    _lo = double(_min) - 0.125 * ext;
+    for ( float v : _pending)
+        _bin(v);
+    _pending.clear();
+    _pending.shrink_to_fit();
+}   // end _init
+
+
+void RangeEstimator::_grow( double v)
+{
+    // Double the bin width until v is inside the range, extending towards v.
+    while ( v < _lo || v >= _lo + _nbins*_width)
+    {
+        std::vector<size_t> nbins( _nbins, 0);
+        const bool down = v < _lo;
+        const size_t off = down ? _nbins/2 : 0;
+        for ( size_t i = 0; i < _nbins; ++i)
+            nbins[off + i/2] += _bins[i];
+        if ( down)
+            _lo -= _nbins * _width;
+        _width *= 2;
+        _bins.swap( nbins);
+    }   // end while
+}   // end _grow
+
+
+void RangeEstimator::_bin( float v, size_t c)
+{
+    _grow(v);
+    const size_t i = std::min( size_t( (double(v) - _lo) / _width), _nbins - 1);
+    _bins[i] += c;
+}   // end _bin
+
+
+void RangeEstimator::merge( const RangeEstimator &re)
+{
+    _nonFinite += re._nonFinite;
+    if ( re._count == 0)
+        return;
+
+    if ( re._bins.empty())  // Other still only has pending (finite) values
+    {
+        for ( float v : re._pending)
+            add(v);
+        return;
+    }   // end if
+
+    // Rebin both histograms over the union of the exact ranges (at source bin centres) so
+    // the merged range stays tight rather than doubling to cover both.
+    std::vector<float> pending;
+    pending.swap( _pending);
+    std::vector<size_t> obins;
+    obins.swap( _bins);
+    const double olo = _lo;
+    const double owidth = _width;
+
+    _count += re._count;
+    _min = std::min( _min, re._min);
+    _max = std::max( _max, re._max);
+    const double ext = std::max( double(_max) - double(_min), std::max( 1e-6, 1e-6 * fabs(_min)));
+    _width = (1.0 + 1e-6) * ext / _nbins;
+    _lo = double(_min);
+    _bins.assign( _nbins, 0);
+
+    const auto addBins = [this]( const std::vector<size_t> &bins, double lo, double width)
+    {
+        for ( size_t i = 0; i < bins.size(); ++i)
+        {
+            if ( bins[i] == 0)
+                continue;
+            const double c = std::min( std::max( lo + (i + 0.5) * width, double(_min)), double(_max));
+            _bin( float(c), bins[i]);
+        }   // end for
+    };
+
+    addBins( obins, olo, owidth);
+    for ( float v : pending)
+        _bin(v);
+    addBins( re._bins, re._lo, re._width);
+}   // end merge
+
+
+float RangeEstimator::percentile( double p) const
+{
+    if ( _count == 0)
+        return 0;
+    p = std::min( std::max( p, 0.0), 100.0);
+    if ( _bins.empty())
+    {
+        std::vector<float> vs( _pending);
+        const size_t i = std::min( size_t( p / 100.0 * vs.size()), vs.size()-1);
+        std::nth_element( vs.begin(), vs.begin() + i, vs.end());
+        return vs[i];
+    }   // end if
+
+    const double target = p / 100.0 * _count;
+    double cum = 0;
+    for ( size_t i = 0; i < _nbins; ++i)
+    {
+        if ( _bins[i] > 0 && cum + _bins[i] >= target)
+        {
+            // Interpolate over the part of the bin inside the known range.
+            const double f = (target - cum) / _bins[i];
+            const double b0 = std::max( _lo + i * _width, double(_min));
+            const double b1 = std::min( _lo + (i + 1) * _width, double(_max));
+            return float( b0 + f * std::max( b1 - b0, 0.0));
+        }   // end if
+        cum += _bins[i];
+    }   // end for
+    return _max;
+}   // end percentile
+
+
+double RangeEstimator::cdf( float v) const
+{
+    if ( _count == 0 || v < _min)
+        return 0;
+    if ( v >= _max)
+        return 1;
+    if ( _bins.empty())
+        return double( std::count_if( _pending.begin(), _pending.end(), [v]( float x){ return x <= v;})) / _count;
+
+    const double x = (double(v) - _lo) / _width;
+    const size_t b = std::min( size_t(x), _nbins - 1);
+    double cum = 0;
+    for ( size_t i = 0; i < b; ++i)
+        cum += _bins[i];
+    cum += (x - b) * _bins[b];  // Assume uniform within the bin
+    return std::min( cum / _count, 1.0);
+}   // end cdf
+
+
+std::vector<size_t> RangeEstimator::histogram( size_t nbins, float lo, float hi) const
+{
+    std::vector<size_t> h( std::max<size_t>( nbins, 1), 0);
+    if ( _count == 0)
+        return h;
+    const double w = hi > lo ? (double(hi) - lo) / h.size() : 1.0;
+    const auto binOf = [&]( double v)
+    {
+        const double i = (v - lo) / w;
+        return i < 0 ? size_t(0) : std::min( size_t(i), h.size() - 1);
+    };
+
+    if ( _bins.empty())
+    {
+        for ( float v : _pending)
+            h[binOf(v)]++;
+    }   // end if
+    else
+    {
+        for ( size_t i = 0; i < _nbins; ++i)
+            if ( _bins[i] > 0)
+                h[binOf( _lo + (i + 0.5) * _width)] += _bins[i];
+    }   // end else
+    return h;
+}   // end histogram
+
+
+namespace {
+
+RangeEstimator parallelEstimate( size_t n, size_t nthreads, size_t nbins,
+                                 const std::function<void( RangeEstimator&, size_t, size_t)> &fn)
+{
+    if ( nthreads == 0)
+        nthreads = std::thread::hardware_concurrency();
+    const size_t nt = std::max<size_t>( 1, std::min( nthreads, n / MIN_PER_THREAD));
+    const size_t chunk = (n + nt - 1) / std::max<size_t>( nt, 1);
+
+    std::vector<std::future<RangeEstimator> > futs;
+    for ( size_t i = chunk; i < n; i += chunk)
+    {
+        const size_t j = std::min( n, i + chunk);
+        futs.push_back( std::async( std::launch::async, [=](){ RangeEstimator re(nbins); fn( re, i, j); return re;}));
+    }   // end for
+
+    RangeEstimator re( nbins);
+    fn( re, 0, std::min( chunk, n));
+    for ( std::future<RangeEstimator> &f : futs)
+        re.merge( f.get());
+    return re;
+}   // end parallelEstimate
+
+}   // end namespace
+
+
+RangeEstimator RangeEstimator::estimate( const vtkFloatArray *arr, int k, size_t nthreads, size_t nbins)
+{
+    vtkFloatArray *fa = const_cast<vtkFloatArray*>(arr);
+    const size_t nc = size_t( fa->GetNumberOfComponents());
+    assert( k >= 0 && size_t(k) < nc);
+    const float *vals = fa->GetPointer(0) + k;
+    return parallelEstimate( size_t( fa->GetNumberOfTuples()), nthreads, nbins,
+                             [=]( RangeEstimator &re, size_t i, size_t j){ re.add( vals + i*nc, j - i, nc);});
+}   // end estimate
+
+
+RangeEstimator RangeEstimator::estimate( const MetricFn &fn, int n, size_t k, size_t nthreads, size_t nbins)
+{
+    return parallelEstimate( size_t( std::max( n, 0)), nthreads, nbins,
+                             [&]( RangeEstimator &re, size_t i, size_t j)
+                             {
+                                for ( size_t id = i; id < j; ++id)
+                                    re.add( fn( int(id), k));
+                             });
+}   // end estimate
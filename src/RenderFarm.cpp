@@ -0,0 +1,682 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <RenderFarm.h>
+#include <OffscreenMeshViewer.h>
+#include <VtkActorCreator.h>
+#include <VtkTools.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <cassert>
+#include <iostream>
+using r3dvis::RenderFarm;
+using r3dvis::RenderResult;
+using r3dvis::SharedMesh;
+using r3dvis::SharedMemory;
+
+
+namespace r3dvis {
+
+// A mapped POSIX shared memory block. The creating side removes the name
+// on destruction (unless already removed) while openers just unmap.
+class SharedMemory
+{
+public:
+    static std::shared_ptr<SharedMemory> create( size_t bytes)
+    {
+        static std::atomic<unsigned> counter(0);
+        const std::string name = "/r3dvis_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+        const int fd = shm_open( name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        if ( fd < 0)
+            return nullptr;
+        if ( ftruncate( fd, off_t(bytes)) != 0)
+        {
+            close(fd);
+            shm_unlink( name.c_str());
+            return nullptr;
+        }   // end if
+        return _map( fd, name, bytes, true, true);
+    }   // end create
+
+    static std::shared_ptr<SharedMemory> open( const std::string &name, size_t bytes, bool writable)
+    {
+        const int fd = shm_open( name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+        if ( fd < 0)
+            return nullptr;
+        return _map( fd, name, bytes, writable, false);
+    }   // end open
+
+    ~SharedMemory()
+    {
+        munmap( _data, std::max<size_t>( _bytes, 1));
+        unlink();
+    }   // end dtor
+
+    // Remove the name so no more processes can open it (existing mappings remain valid).
+    void unlink()
+    {
+        if ( _owner)
+            shm_unlink( _name.c_str());
+        _owner = false;
+    }   // end unlink
+
+    void *data() const { return _data;}
+    size_t bytes() const { return _bytes;}
+    const std::string &name() const { return _name;}
+
+private:
+    std::string _name;
+    void *_data;
+    size_t _bytes;
+    bool _owner;
+
+    static std::shared_ptr<SharedMemory> _map( int fd, const std::string &name, size_t bytes, bool writable, bool owner)
+    {
+        const int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void *data = mmap( nullptr, std::max<size_t>( bytes, 1), prot, MAP_SHARED, fd, 0);
+        close(fd);  // Mapping stays valid
+        if ( data == MAP_FAILED)
+        {
+            if ( owner)
+                shm_unlink( name.c_str());
+            return nullptr;
+        }   // end if
+        std::shared_ptr<SharedMemory> shm( new SharedMemory);
+        shm->_name = name;
+        shm->_data = data;
+        shm->_bytes = bytes;
+        shm->_owner = owner;
+        return shm;
+    }   // end _map
+};  // end class
+
+}   // end namespace
+
+
+namespace {
+
+const uint32_t MESH_MAGIC = 0x72336d31;    // "r3m1"
+const uint32_t JOB_MAGIC = 0x72336a31;     // "r3j1"
+const size_t NAME_LEN = 64;
+
+struct MeshHeader
+{
+    uint32_t magic;
+    uint32_t nvtxs;
+    uint32_t nfaces;
+    int32_t txrows;     // Zero if no texture
+    int32_t txcols;
+    uint32_t pad;
+    float T[16];        // Row major transform
+};  // end struct
+
+struct JobHeader
+{
+    uint32_t magic;
+    uint32_t ncams;
+    int32_t width;
+    int32_t height;
+    double bg[3];
+    uint64_t meshBytes;
+    uint64_t imageBytes;
+    char meshName[NAME_LEN];
+    char imageName[NAME_LEN];
+};  // end struct
+
+struct CameraRecord
+{
+    float pos[3];
+    float focus[3];
+    float up[3];
+    float fov;
+};  // end struct
+
+struct Reply
+{
+    uint32_t magic;
+    int32_t status;     // Zero on success
+};  // end struct
+
+
+size_t meshBytes( size_t nv, size_t nf, const cv::Size &txsz)
+{
+    size_t n = sizeof(MeshHeader) + 3*nv*sizeof(float) + 3*nf*sizeof(int32_t);
+    if ( txsz.area() > 0)
+        n += 6*nf*sizeof(float) + size_t(txsz.area())*3;
+    return n;
+}   // end meshBytes
+
+
+bool writeAll( int fd, const void *buf, size_t n)
+{
+    const char *p = static_cast<const char*>(buf);
+    while ( n > 0)
+    {
+        const ssize_t k = send( fd, p, n, MSG_NOSIGNAL);   // No SIGPIPE if peer died
+        if ( k < 0 && errno == EINTR)
+            continue;
+        if ( k <= 0)
+            return false;
+        p += k;
+        n -= size_t(k);
+    }   // end while
+    return true;
+}   // end writeAll
+
+
+// Read exactly n bytes. If timeoutMs is non-negative, fail if they haven't
+// all arrived within that many milliseconds of the call.
+bool readAll( int fd, void *buf, size_t n, int timeoutMs=-1)
+{
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds( std::max( timeoutMs, 0));
+    char *p = static_cast<char*>(buf);
+    while ( n > 0)
+    {
+        if ( timeoutMs >= 0)
+        {
+            const long long left = std::chrono::duration_cast<std::chrono::milliseconds>( deadline - Clock::now()).count();
+            if ( left <= 0)
+                return false;
+            pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            const int r = poll( &pfd, 1, int(left));
+            if ( r < 0 && errno == EINTR)
+                continue;
+            if ( r <= 0)    // Error or timed out
+                return false;
+        }   // end if
+
+        const ssize_t k = recv( fd, p, n, 0);
+        if ( k < 0 && errno == EINTR)
+            continue;
+        if ( k <= 0)    // Error or peer closed
+            return false;
+        p += k;
+        n -= size_t(k);
+    }   // end while
+    return true;
+}   // end readAll
+
+}   // end namespace
+
+
+SharedMesh::Ptr SharedMesh::create( const r3d::Mesh &mesh)
+{
+    if ( !mesh.hasSequentialIds() || mesh.numMats() > 1)
+    {
+        std::cerr << "[ERROR] r3dvis::SharedMesh::create: Mesh must have sequential IDs and at most one material!" << std::endl;
+        return nullptr;
+    }   // end if
+
+    const int nv = int(mesh.numVtxs());
+    const int nf = int(mesh.numFaces());
+    const int MID = mesh.numMats() == 1 ? *mesh.materialIds().begin() : -1;
+    cv::Mat tx;
+    if ( MID >= 0)
+    {
+        tx = mesh.texture(MID);
+        if ( tx.channels() == 1)
+            cv::cvtColor( tx, tx, cv::COLOR_GRAY2BGR);
+        else if ( tx.channels() == 4)
+            cv::cvtColor( tx, tx, cv::COLOR_BGRA2BGR);
+        if ( !tx.isContinuous())
+            tx = tx.clone();
+        assert( tx.type() == CV_8UC3);
+    }   // end if
+
+    const size_t nbytes = meshBytes( size_t(nv), size_t(nf), tx.size());
+    std::shared_ptr<SharedMemory> shm = SharedMemory::create( nbytes);
+    if ( !shm)
+    {
+        std::cerr << "[ERROR] r3dvis::SharedMesh::create: Unable to create shared memory block!" << std::endl;
+        return nullptr;
+    }   // end if
+
+    char *p = static_cast<char*>(shm->data());
+    MeshHeader *hdr = reinterpret_cast<MeshHeader*>(p);
+    hdr->magic = MESH_MAGIC;
+    hdr->nvtxs = uint32_t(nv);
+    hdr->nfaces = uint32_t(nf);
+    hdr->txrows = tx.rows;
+    hdr->txcols = tx.cols;
+    hdr->pad = 0;
+    const r3d::Mat4f &T = mesh.transformMatrix();
+    for ( int i = 0; i < 4; ++i)
+        for ( int j = 0; j < 4; ++j)
+            hdr->T[4*i+j] = T(i,j);
+    p += sizeof(MeshHeader);
+
+    float *vtxs = reinterpret_cast<float*>(p);
+    for ( int vid = 0; vid < nv; ++vid)
+    {
+        const r3d::Vec3f &v = mesh.uvtx(vid);
+        *vtxs++ = v[0];
+        *vtxs++ = v[1];
+        *vtxs++ = v[2];
+    }   // end for
+    p = reinterpret_cast<char*>(vtxs);
+
+    int32_t *fvs = reinterpret_cast<int32_t*>(p);
+    for ( int fid = 0; fid < nf; ++fid)
+    {
+        const int *fvidxs = mesh.fvidxs(fid);
+        *fvs++ = fvidxs[0];
+        *fvs++ = fvidxs[1];
+        *fvs++ = fvidxs[2];
+    }   // end for
+    p = reinterpret_cast<char*>(fvs);
+
+    if ( !tx.empty())
+    {
+        float *uvs = reinterpret_cast<float*>(p);
+        for ( int fid = 0; fid < nf; ++fid)
+        {
+            const int *uvids = mesh.faceUVs(fid);
+            for ( int i = 0; i < 3; ++i)
+            {
+                const r3d::Vec2f uv = uvids ? mesh.uv( MID, uvids[i]) : r3d::Vec2f(0,0);
+                *uvs++ = uv[0];
+                *uvs++ = uv[1];
+            }   // end for
+        }   // end for
+        p = reinterpret_cast<char*>(uvs);
+        memcpy( p, tx.data, tx.total()*3);
+    }   // end if
+
+    Ptr smesh( new SharedMesh);
+    smesh->_shm = shm;
+    return smesh;
+}   // end create
+
+
+const std::string &SharedMesh::name() const { return _shm->name();}
+size_t SharedMesh::bytes() const { return _shm->bytes();}
+
+
+r3d::Mesh::Ptr SharedMesh::read( const void *data, size_t nbytes, r3d::Mat4f &T)
+{
+    const char *p = static_cast<const char*>(data);
+    const MeshHeader *hdr = reinterpret_cast<const MeshHeader*>(p);
+    if ( nbytes < sizeof(MeshHeader) || hdr->magic != MESH_MAGIC)
+        return nullptr;
+    const cv::Size txsz( hdr->txcols, hdr->txrows);
+    if ( hdr->txrows < 0 || hdr->txcols < 0 || nbytes < meshBytes( hdr->nvtxs, hdr->nfaces, txsz))
+        return nullptr;
+
+    for ( int i = 0; i < 4; ++i)
+        for ( int j = 0; j < 4; ++j)
+            T(i,j) = hdr->T[4*i+j];
+    p += sizeof(MeshHeader);
+
+    r3d::Mesh::Ptr mesh = r3d::Mesh::create();
+    const int nv = int(hdr->nvtxs);
+    const float *vtxs = reinterpret_cast<const float*>(p);
+    for ( int vid = 0; vid < nv; ++vid, vtxs += 3)
+        mesh->addVertex( vtxs[0], vtxs[1], vtxs[2]);
+    p = reinterpret_cast<const char*>(vtxs);
+
+    const int nf = int(hdr->nfaces);
+    const int32_t *fvs = reinterpret_cast<const int32_t*>(p);
+    for ( int fid = 0; fid < nf; ++fid, fvs += 3)
+    {
+        for ( int i = 0; i < 3; ++i)
+            if ( fvs[i] < 0 || fvs[i] >= nv)    // Don't trust the block's contents
+                return nullptr;
+        mesh->addFace( fvs[0], fvs[1], fvs[2]);
+    }   // end for
+    p = reinterpret_cast<const char*>(fvs);
+
+    if ( hdr->txrows > 0 && hdr->txcols > 0)
+    {
+        const float *uvs = reinterpret_cast<const float*>(p);
+        const cv::Mat tx( txsz, CV_8UC3, const_cast<char*>(p + 6*size_t(nf)*sizeof(float)));
+        const int MID = mesh->addMaterial( tx.clone());
+        for ( int fid = 0; fid < nf; ++fid, uvs += 6)
+            mesh->setOrderedFaceUVs( MID, fid, r3d::Vec2f( uvs[0], uvs[1]),
+                                               r3d::Vec2f( uvs[2], uvs[3]),
+                                               r3d::Vec2f( uvs[4], uvs[5]));
+    }   // end if
+
+    return mesh;
+}   // end read
+
+
+struct RenderFarm::Job
+{
+    SharedMesh::Ptr mesh;
+    std::vector<r3d::CameraParams> cams;
+    cv::Size dims;
+    cv::Vec3d bg;
+    std::promise<RenderResult> result;
+};  // end struct
+
+
+struct RenderFarm::Worker
+{
+    pid_t pid = -1;
+    int fd = -1;
+    std::thread thread;
+};  // end struct
+
+
+RenderFarm::Ptr RenderFarm::create( size_t nworkers, const std::string &exe)
+{
+    return Ptr( new RenderFarm( nworkers, exe));
+}   // end create
+
+
+RenderFarm::RenderFarm( size_t nworkers, const std::string &exe) : _exe(exe), _timeoutMs(60000), _stopping(false)
+{
+    if ( nworkers == 0)
+        nworkers = std::max<size_t>( 1, std::thread::hardware_concurrency());
+    for ( size_t i = 0; i < nworkers; ++i)
+    {
+        _workers.emplace_back( new Worker);
+        Worker &w = *_workers.back();
+        if ( !_spawn( w))
+            std::cerr << "[WARNING] r3dvis::RenderFarm: Unable to launch worker " << _exe << std::endl;
+        w.thread = std::thread( [this, &w](){ _dispatch(w);});
+    }   // end for
+}   // end ctor
+
+
+RenderFarm::~RenderFarm()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stopping = true;
+    }
+    _cv.notify_all();
+    for ( std::unique_ptr<Worker> &w : _workers)
+    {
+        w->thread.join();
+        _kill( *w);
+    }   // end for
+}   // end dtor
+
+
+bool RenderFarm::_spawn( Worker &w)
+{
+    int fds[2];
+    // Both ends are close-on-exec from creation so neither can leak into a process forked
+    // by another thread. The child clears the flag on its own end before exec.
+    if ( socketpair( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        return false;
+
+    // Prepare the arguments before forking since only async-signal-safe
+    // functions may be called in the child of a multithreaded process.
+    const std::string fdarg = std::to_string( fds[1]);
+    char *argv[] = { const_cast<char*>(_exe.c_str()), const_cast<char*>(fdarg.c_str()), nullptr};
+
+    const pid_t pid = fork();
+    if ( pid < 0)
+    {
+        close( fds[0]);
+        close( fds[1]);
+        return false;
+    }   // end if
+
+    if ( pid == 0)  // Child
+    {
+        fcntl( fds[1], F_SETFD, 0);
+        execvp( argv[0], argv);
+        _exit(127);
+    }   // end if
+
+    close( fds[1]);
+    w.pid = pid;
+    w.fd = fds[0];
+    return true;
+}   // end _spawn
+
+
+void RenderFarm::_kill( Worker &w)
+{
+    if ( w.fd >= 0)
+        close( w.fd);   // Worker exits on reading EOF
+    if ( w.pid > 0)
+    {
+        int status;
+        if ( waitpid( w.pid, &status, WNOHANG) == 0)
+        {
+            usleep( 100000);
+            if ( waitpid( w.pid, &status, WNOHANG) == 0)
+            {
+                kill( w.pid, SIGKILL);
+                waitpid( w.pid, &status, 0);
+            }   // end if
+        }   // end if
+    }   // end if
+    w.fd = -1;
+    w.pid = -1;
+}   // end _kill
+
+
+std::future<RenderResult> RenderFarm::render( const SharedMesh::Ptr &mesh,
+                                              const std::vector<r3d::CameraParams> &cams,
+                                              const cv::Size &dims, const cv::Vec3d &bg)
+{
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->mesh = mesh;
+    job->cams = cams;
+    job->dims = dims;
+    job->bg = bg;
+    std::future<RenderResult> fut = job->result.get_future();
+    if ( !mesh || dims.area() <= 0)
+    {
+        job->result.set_value( RenderResult());
+        return fut;
+    }   // end if
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _jobs.push_back( job);
+    }
+    _cv.notify_one();
+    return fut;
+}   // end render
+
+
+void RenderFarm::_dispatch( Worker &w)
+{
+    while ( true)
+    {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _cv.wait( lock, [this](){ return _stopping || !_jobs.empty();});
+            if ( _jobs.empty())
+                break;
+            job = _jobs.front();
+            _jobs.pop_front();
+        }
+
+        bool ok = false;
+        for ( int attempt = 0; attempt < 2 && !ok; ++attempt)
+        {
+            if ( w.pid < 0 && !_spawn(w))
+                break;
+            ok = _runJob( w, *job);
+            if ( !ok)   // Assume the worker died or is in a bad state so restart it
+            {
+                std::cerr << "[WARNING] r3dvis::RenderFarm: Restarting worker process " << w.pid << std::endl;
+                _kill(w);
+            }   // end if
+        }   // end for
+
+        if ( !ok)
+        {
+            std::cerr << "[ERROR] r3dvis::RenderFarm: Render job failed!" << std::endl;
+            job->result.set_value( RenderResult());
+        }   // end if
+    }   // end while
+}   // end _dispatch
+
+
+bool RenderFarm::_runJob( Worker &w, Job &job)
+{
+    const size_t imgBytes = size_t(job.dims.area()) * 3;
+    std::shared_ptr<SharedMemory> buf = SharedMemory::create( imgBytes * job.cams.size());
+    if ( !buf)  // Client side problem (e.g. /dev/shm full) so fail just this job and keep the worker
+    {
+        std::cerr << "[ERROR] r3dvis::RenderFarm::_runJob: Unable to create shared memory for job images!" << std::endl;
+        job.result.set_value( RenderResult());
+        return true;
+    }   // end if
+
+    JobHeader hdr;
+    memset( &hdr, 0, sizeof(JobHeader));
+    hdr.magic = JOB_MAGIC;
+    hdr.ncams = uint32_t( job.cams.size());
+    hdr.width = job.dims.width;
+    hdr.height = job.dims.height;
+    hdr.bg[0] = job.bg[0];
+    hdr.bg[1] = job.bg[1];
+    hdr.bg[2] = job.bg[2];
+    hdr.meshBytes = job.mesh->bytes();
+    hdr.imageBytes = buf->bytes();
+    strncpy( hdr.meshName, job.mesh->name().c_str(), NAME_LEN-1);
+    strncpy( hdr.imageName, buf->name().c_str(), NAME_LEN-1);
+
+    std::vector<CameraRecord> crecs( job.cams.size());
+    for ( size_t i = 0; i < job.cams.size(); ++i)
+    {
+        const r3d::CameraParams &cam = job.cams[i];
+        for ( int j = 0; j < 3; ++j)
+        {
+            crecs[i].pos[j] = cam.pos()[j];
+            crecs[i].focus[j] = cam.focus()[j];
+            crecs[i].up[j] = cam.up()[j];
+        }   // end for
+        crecs[i].fov = cam.fov();
+    }   // end for
+
+    // A worker that doesn't reply in time is assumed hung and gets restarted.
+    Reply reply;
+    if ( !writeAll( w.fd, &hdr, sizeof(JobHeader))
+      || !writeAll( w.fd, crecs.data(), crecs.size()*sizeof(CameraRecord))
+      || !readAll( w.fd, &reply, sizeof(Reply), _timeoutMs.load())
+      || reply.magic != JOB_MAGIC)
+        return false;
+
+    buf->unlink();  // Worker is finished with it
+
+    RenderResult res;
+    if ( reply.status == 0)
+    {
+        res.buffer = buf;
+        byte *data = static_cast<byte*>(buf->data());
+        for ( size_t i = 0; i < job.cams.size(); ++i)
+            res.images.push_back( cv::Mat_<cv::Vec3b>( job.dims, reinterpret_cast<cv::Vec3b*>(data + i*imgBytes)));
+    }   // end if
+    else
+        std::cerr << "[WARNING] r3dvis::RenderFarm: Worker couldn't render job (status " << reply.status << ")" << std::endl;
+
+    // A non-zero status is a handled failure (e.g. bad mesh) so don't restart the worker.
+    job.result.set_value( res);
+    return true;
+}   // end _runJob
+
+
+namespace {
+
+int renderJob( r3dvis::OffscreenMeshViewer &viewer, const JobHeader &hdr,
+               const std::vector<CameraRecord> &crecs, std::string &meshName)
+{
+    if ( meshName != hdr.meshName)
+    {
+        meshName.clear();
+        viewer.clear();
+        std::shared_ptr<SharedMemory> mshm = SharedMemory::open( hdr.meshName, hdr.meshBytes, false);
+        if ( !mshm)
+            return 1;
+        r3d::Mat4f T;
+        r3d::Mesh::Ptr mesh = SharedMesh::read( mshm->data(), mshm->bytes(), T);
+        if ( !mesh)
+            return 2;
+        vtkSmartPointer<vtkActor> actor = r3dvis::VtkActorCreator::generateActor( *mesh);
+        if ( !actor)
+            return 3;
+        actor->PokeMatrix( r3dvis::toVTK(T));
+        viewer.setActor( actor);
+        meshName = hdr.meshName;
+    }   // end if
+
+    const cv::Size dims( hdr.width, hdr.height);
+    const size_t imgBytes = size_t(dims.area()) * 3;
+    if ( hdr.imageBytes < imgBytes * hdr.ncams)
+        return 4;
+    std::shared_ptr<SharedMemory> ishm = SharedMemory::open( hdr.imageName, hdr.imageBytes, true);
+    if ( !ishm)
+        return 5;
+
+    viewer.setSize( dims);
+    viewer.setBackgroundColour( hdr.bg[0], hdr.bg[1], hdr.bg[2]);
+    r3dvis::byte *data = static_cast<r3dvis::byte*>(ishm->data());
+    for ( size_t i = 0; i < crecs.size(); ++i)
+    {
+        const CameraRecord &c = crecs[i];
+        viewer.setCamera( r3d::CameraParams( r3d::Vec3f( c.pos[0], c.pos[1], c.pos[2]),
+                                             r3d::Vec3f( c.focus[0], c.focus[1], c.focus[2]),
+                                             r3d::Vec3f( c.up[0], c.up[1], c.up[2]), c.fov));
+        // Read the pixels straight into the client's buffer
+        cv::Mat_<cv::Vec3b> dst( dims, reinterpret_cast<cv::Vec3b*>(data + i*imgBytes));
+        if ( !viewer.snapshot( dst))
+            return 6;
+    }   // end for
+
+    return 0;
+}   // end renderJob
+
+}   // end namespace
+
+
+int RenderFarm::serve( int fd)
+{
+    OffscreenMeshViewer viewer( cv::Size(512,512));
+    std::string meshName;
+    JobHeader hdr;
+    while ( readAll( fd, &hdr, sizeof(JobHeader)))
+    {
+        if ( hdr.magic != JOB_MAGIC)
+            return 1;
+        hdr.meshName[NAME_LEN-1] = 0;
+        hdr.imageName[NAME_LEN-1] = 0;
+        std::vector<CameraRecord> crecs( hdr.ncams);
+        if ( !readAll( fd, crecs.data(), crecs.size()*sizeof(CameraRecord)))
+            return 1;
+
+        Reply reply;
+        reply.magic = JOB_MAGIC;
+        reply.status = renderJob( viewer, hdr, crecs, meshName);
+        if ( !writeAll( fd, &reply, sizeof(Reply)))
+            return 1;
+    }   // end while
+    return 0;   // Client closed the socket
+}   // end serve
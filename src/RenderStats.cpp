@@ -0,0 +1,307 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <RenderStats.h>
+#include <vtkPropCollection.h>
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkTexture.h>
+#include <vtkMapper.h>
+#include <vtkActor.h>
+#include <unordered_set>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+using r3dvis::RenderRecord;
+using r3dvis::RingBufferSink;
+using r3dvis::CSVSink;
+using r3dvis::ChromeTraceSink;
+using r3dvis::RenderStats;
+using r3dvis::RenderTimer;
+using r3dvis::CaptureTimer;
+using r3dvis::SelectionTimer;
+
+
+namespace {
+
+size_t _threadId()
+{
+    static std::atomic<size_t> nextId(0);
+    thread_local const size_t tid = nextId++;
+    return tid;
+}   // end _threadId
+
+
+// Number of triangles in the cells of a polygon or strip array.
+size_t _numTriangles( vtkCellArray *cells)
+{
+    if ( !cells)
+        return 0;
+    const vtkIdType nc = cells->GetNumberOfCells();
+    return size_t( std::max<vtkIdType>( 0, cells->GetNumberOfConnectivityIds() - 2*nc));
+}   // end _numTriangles
+
+
+std::string _jsonEscape( const std::string &s)
+{
+    std::string out;
+    out.reserve( s.size());
+    for ( char c : s)
+    {
+        if ( c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }   // end for
+    return out;
+}   // end _jsonEscape
+
+}   // end namespace
+
+
+RenderRecord::RenderRecord()
+    : threadId(0), startUs(0), wallMs(0), numRenders(0), renderMs(0), captureMs(0),
+      numTriangles(0), numPoints(0), textureBytes(0) {}
+
+
+RingBufferSink::RingBufferSink( size_t cap) : _cap( std::max<size_t>( 1, cap)), _next(0)
+{
+    _recs.reserve( _cap);
+}   // end ctor
+
+
+void RingBufferSink::write( const RenderRecord &rec)
+{
+    std::lock_guard<std::mutex> lock( _mtx);
+    if ( _recs.size() < _cap)
+        _recs.push_back( rec);
+    else
+        _recs[_next] = rec;
+    _next = (_next + 1) % _cap;
+}   // end write
+
+
+std::vector<RenderRecord> RingBufferSink::records() const
+{
+    std::lock_guard<std::mutex> lock( _mtx);
+    if ( _recs.size() < _cap)
+        return _recs;
+    std::vector<RenderRecord> recs( _recs.begin() + _next, _recs.end());
+    recs.insert( recs.end(), _recs.begin(), _recs.begin() + _next);
+    return recs;
+}   // end records
+
+
+size_t RingBufferSink::size() const
+{
+    std::lock_guard<std::mutex> lock( _mtx);
+    return _recs.size();
+}   // end size
+
+
+void RingBufferSink::clear()
+{
+    std::lock_guard<std::mutex> lock( _mtx);
+    _recs.clear();
+    _next = 0;
+}   // end clear
+
+
+CSVSink::CSVSink( const std::string &fname) : _ofs( fname)
+{
+    if ( !_ofs.is_open())
+    {
+        std::cerr << "[ERROR] r3dvis::CSVSink: Unable to open " << fname << " for writing!" << std::endl;
+        return;
+    }   // end if
+    _ofs << "label,thread,start_us,wall_ms,renders,render_ms,capture_ms,triangles,points,texture_bytes" << std::endl;
+}   // end ctor
+
+
+void CSVSink::write( const RenderRecord &rec)
+{
+    std::lock_guard<std::mutex> lock( _mtx);
+    if ( !_ofs.is_open())
+        return;
+    _ofs << rec.label << "," << rec.threadId << "," << std::fixed << std::setprecision(1) << rec.startUs
+         << "," << std::setprecision(3) << rec.wallMs << "," << rec.numRenders << "," << rec.renderMs
+         << "," << rec.captureMs << "," << rec.numTriangles << "," << rec.numPoints << "," << rec.textureBytes << "\n";
+}   // end write
+
+
+ChromeTraceSink::ChromeTraceSink( const std::string &fname) : _ofs( fname), _first(true)
+{
+    if ( !_ofs.is_open())
+    {
+        std::cerr << "[ERROR] r3dvis::ChromeTraceSink: Unable to open " << fname << " for writing!" << std::endl;
+        return;
+    }   // end if
+    _ofs << "[";
+}   // end ctor
+
+
+ChromeTraceSink::~ChromeTraceSink()
+{
+    if ( _ofs.is_open())
+        _ofs << "\n]\n";
+}   // end dtor
+
+
+void ChromeTraceSink::write( const RenderRecord &rec)
+{
+    std::lock_guard<std::mutex> lock( _mtx);
+    if ( !_ofs.is_open())
+        return;
+    if ( !_first)
+        _ofs << ",";
+    _first = false;
+    _ofs << "\n{\"name\":\"" << _jsonEscape( rec.label) << "\",\"cat\":\"r3dvis\",\"ph\":\"X\""
+         << std::fixed << std::setprecision(1)
+         << ",\"ts\":" << rec.startUs << ",\"dur\":" << rec.wallMs * 1000
+         << ",\"pid\":0,\"tid\":" << rec.threadId
+         << ",\"args\":{\"renders\":" << rec.numRenders
+         << std::setprecision(3)
+         << ",\"render_ms\":" << rec.renderMs << ",\"capture_ms\":" << rec.captureMs
+         << ",\"triangles\":" << rec.numTriangles << ",\"points\":" << rec.numPoints
+         << ",\"texture_bytes\":" << rec.textureBytes << "}}";
+}   // end write
+
+
+RenderStats::RenderStats() : _nrenders(0), _renderMs(0), _captureMs(0) {}
+
+
+void RenderStats::addSink( const RenderSink::Ptr &sink)
+{
+    if ( sink && std::find( _sinks.begin(), _sinks.end(), sink) == _sinks.end())
+        _sinks.push_back( sink);
+}   // end addSink
+
+
+void RenderStats::removeSink( const RenderSink::Ptr &sink)
+{
+    _sinks.erase( std::remove( _sinks.begin(), _sinks.end(), sink), _sinks.end());
+}   // end removeSink
+
+
+void RenderStats::clearSinks() { _sinks.clear();}
+
+
+void RenderStats::write( const RenderRecord &rec) const
+{
+    for ( const RenderSink::Ptr &sink : _sinks)
+        sink->write( rec);
+}   // end write
+
+
+void RenderStats::sceneStats( vtkRenderer *ren, RenderRecord &rec)
+{
+    rec.numTriangles = 0;
+    rec.numPoints = 0;
+    rec.textureBytes = 0;
+    std::unordered_set<const vtkImageData*> textures;
+
+    vtkPropCollection *props = ren->GetViewProps();
+    vtkCollectionSimpleIterator it;
+    props->InitTraversal( it);
+    while ( vtkProp *prop = props->GetNextProp( it))
+    {
+        vtkActor *actor = vtkActor::SafeDownCast( prop);
+        if ( !actor || !actor->GetVisibility() || !actor->GetMapper())
+            continue;
+
+        if ( vtkPolyData *pd = vtkPolyData::SafeDownCast( actor->GetMapper()->GetInputAsDataSet()))
+        {
+            rec.numPoints += size_t( pd->GetNumberOfPoints());
+            rec.numTriangles += _numTriangles( pd->GetPolys()) + _numTriangles( pd->GetStrips());
+        }   // end if
+
+        vtkTexture *tx = actor->GetTexture();
+        vtkImageData *img = tx ? tx->GetInput() : nullptr;
+        if ( img && textures.insert( img).second)
+            rec.textureBytes += size_t( img->GetActualMemorySize()) * 1024;
+    }   // end while
+}   // end sceneStats
+
+
+double RenderStats::nowUs()
+{
+    using Clock = std::chrono::steady_clock;
+    static const Clock::time_point t0 = Clock::now();
+    return std::chrono::duration<double, std::micro>( Clock::now() - t0).count();
+}   // end nowUs
+
+
+RenderTimer::RenderTimer( RenderStats *stats, const char *label, vtkRenderer *ren)
+    : _stats( stats && stats->enabled() ? stats : nullptr), _label(label), _ren(ren),
+      _t0(0), _n0(0), _r0(0), _c0(0)
+{
+    if ( !_stats)
+        return;
+    _n0 = _stats->_nrenders;
+    _r0 = _stats->_renderMs;
+    _c0 = _stats->_captureMs;
+    _t0 = RenderStats::nowUs();
+}   // end ctor
+
+
+RenderTimer::~RenderTimer()
+{
+    if ( !_stats)
+        return;
+    RenderRecord rec;
+    rec.wallMs = (RenderStats::nowUs() - _t0) / 1000;
+    rec.label = _label;
+    rec.threadId = _threadId();
+    rec.startUs = _t0;
+    rec.numRenders = _stats->_nrenders - _n0;
+    rec.renderMs = _stats->_renderMs - _r0;
+    rec.captureMs = _stats->_captureMs - _c0;
+    if ( _ren)
+        RenderStats::sceneStats( _ren, rec);
+    _stats->write( rec);
+}   // end dtor
+
+
+CaptureTimer::CaptureTimer( RenderStats *stats)
+    : _stats( stats && stats->enabled() ? stats : nullptr), _t0(0)
+{
+    if ( _stats)
+        _t0 = RenderStats::nowUs();
+}   // end ctor
+
+
+CaptureTimer::~CaptureTimer()
+{
+    if ( _stats)
+        _stats->addCapture( (RenderStats::nowUs() - _t0) / 1000);
+}   // end dtor
+
+
+SelectionTimer::SelectionTimer( RenderStats *stats)
+    : _stats( stats && stats->enabled() ? stats : nullptr), _t0(0)
+{
+    if ( _stats)
+        _t0 = RenderStats::nowUs();
+}   // end ctor
+
+
+SelectionTimer::~SelectionTimer()
+{
+    if ( _stats)
+        _stats->addRender( (RenderStats::nowUs() - _t0) / 1000);
+}   // end dtor
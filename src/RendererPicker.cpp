@@ -16,18 +16,32 @@
  ************************************************************************/
 
 #include <RendererPicker.h>
+#include <VtkTools.h>
 #include <vtkProp3DCollection.h>
+#include <vtkPropCollection.h>
+#include <vtkCamera.h>
 #include <vtkCellPicker.h>
 #include <vtkPropPicker.h>
 #include <vtkSmartPointer.h>
 #include <vtkCoordinate.h>
 #include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkMapper.h>
+#include <opencv2/imgproc.hpp>
 #include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
+#include <iostream>
 #include <cassert>
+#include <climits>
+#include <cmath>
 using r3dvis::RendererPicker;
+using r3dvis::RenderTimer;
+using r3dvis::CaptureTimer;
+using r3dvis::SelectionTimer;
+using r3dvis::RenderStats;
 using r3d::Vec3f;
+using r3dvis::byte;
 
 
 namespace {
@@ -47,13 +61,82 @@ bool _isValidPoint( vtkRenderer *ren, const cv::Point& p)
 
 
 RendererPicker::RendererPicker( vtkRenderer* ren, PointOrigin po, double t)
-    : _ren(ren), _pointOrigin(po), _tolerance(t)
+    : _ren(ren), _pointOrigin(po), _tolerance(t), _stats(nullptr),
+      _cpicker( vtkSmartPointer<vtkCellPicker>::New()),
+      _ppicker( vtkSmartPointer<vtkPropPicker>::New())
 {
     assert(ren);
     _ren->ResetCameraClippingRange();
+    _cpicker->SetTolerance(_tolerance);
+    _cpicker->PickFromListOn();
 }   // end ctor
 
 
+void RendererPicker::clearLocators()
+{
+    _cpicker->RemoveAllLocators();
+    _locators.clear();
+}   // end clearLocators
+
+
+void RendererPicker::_updateLocator( const vtkProp *prop) const
+{
+    const vtkActor *actor = vtkActor::SafeDownCast( const_cast<vtkProp*>(prop));
+    if ( !actor)
+        return;
+    vtkMapper *mapper = const_cast<vtkActor*>(actor)->GetMapper();
+    vtkPolyData *pd = mapper ? vtkPolyData::SafeDownCast( mapper->GetInputAsDataSet()) : nullptr;
+    if ( !pd || pd->GetNumberOfCells() == 0)
+        return;
+
+    auto it = _locators.find( prop);
+    if ( it != _locators.end() && it->second.prop.GetPointer() != prop)   // Address reused by a new prop
+    {
+        _cpicker->RemoveLocator( it->second.locator);
+        _locators.erase( it);
+        it = _locators.end();
+    }   // end if
+    if ( it == _locators.end())
+    {
+        _evictLocators();
+        it = _locators.emplace( prop, CachedLocator()).first;
+        it->second.prop = const_cast<vtkProp*>(prop);
+    }   // end if
+
+    CachedLocator &cl = it->second;
+    if ( cl.locator && cl.pdata == pd && cl.mtime >= pd->GetMTime())
+        return; // Still valid
+
+    if ( cl.locator)
+        _cpicker->RemoveLocator( cl.locator);
+    cl.pdata = pd;
+    cl.mtime = pd->GetMTime();
+    cl.locator = vtkSmartPointer<vtkStaticCellLocator>::New();
+    cl.locator->SetDataSet( pd);
+    cl.locator->BuildLocator();
+    _cpicker->AddLocator( cl.locator);
+}   // end _updateLocator
+
+
+void RendererPicker::_evictLocators() const
+{
+    // Drop locators for props that have been deleted or removed from the renderer
+    // so they don't keep the props' data alive.
+    vtkPropCollection *props = _ren->GetViewProps();
+    for ( auto it = _locators.begin(); it != _locators.end();)
+    {
+        if ( !it->second.prop || !props->IsItemPresent( it->second.prop))
+        {
+            if ( it->second.locator)
+                _cpicker->RemoveLocator( it->second.locator);
+            it = _locators.erase( it);
+        }   // end if
+        else
+            ++it;
+    }   // end for
+}   // end _evictLocators
+
+
 namespace {
 cv::Point changeOriginOfPoint( vtkRenderer* ren, const cv::Point& p, RendererPicker::PointOrigin po)
 {
@@ -66,16 +149,23 @@ cv::Point changeOriginOfPoint( vtkRenderer* ren, const cv::Point& p, RendererPic
 }   // end namespace
 
 
+cv::Point RendererPicker::toPixels( vtkRenderer *ren, const cv::Point2f &p) { return _toPxls( ren, p);}
+bool RendererPicker::isValidPoint( vtkRenderer *ren, const cv::Point &p) { return _isValidPoint( ren, p);}
+cv::Point RendererPicker::toBottomLeft( vtkRenderer *ren, const cv::Point &p, PointOrigin po) { return changeOriginOfPoint( ren, p, po);}
+
+
 const vtkActor* RendererPicker::pickActor( const cv::Point& p) const
 {
+    RenderTimer timer( _stats, "RendererPicker::pickActor", _ren);
     if ( !_isValidPoint( _ren, p))
         return nullptr;
 
     const cv::Point np = changeOriginOfPoint( _ren, p, _pointOrigin);
-    vtkNew<vtkPropPicker> ppicker;
     vtkActor* act = nullptr;
-    if ( ppicker->PickProp( np.x, np.y, _ren) > 0)
-        act = ppicker->GetActor();
+    SelectionTimer stimer( _stats);
+    if ( _ppicker->PickProp( np.x, np.y, _ren) > 0)
+        act = _ppicker->GetActor();
+    _ren->Modified();   // The selection pass overwrites the frame buffer
     return act;
 }   // end pickActor
 
@@ -95,15 +185,16 @@ vtkNew<vtkPropCollection> createPropCollection( const std::vector<const vtkProp*
 }   // end createPropCollection
 
 
-const vtkActor* pick( const cv::Point& p, vtkNew<vtkPropCollection> pickFrom,
-                       vtkRenderer* ren, RendererPicker::PointOrigin po)
+const vtkActor* pick( const cv::Point& p, vtkNew<vtkPropCollection> pickFrom, vtkRenderer* ren,
+                      RenderStats *stats, RendererPicker::PointOrigin po, vtkPropPicker *propPicker)
 {
     if ( !_isValidPoint( ren, p))
         return nullptr;
     const cv::Point np = changeOriginOfPoint( ren, p, po);
-    vtkNew<vtkPropPicker> propPicker;
-    propPicker->PickProp( np.x, np.y, ren, pickFrom);
-    return propPicker->GetActor();
+    SelectionTimer stimer( stats);
+    const int picked = propPicker->PickProp( np.x, np.y, ren, pickFrom);
+    ren->Modified();    // The selection pass overwrites the frame buffer
+    return picked > 0 ? propPicker->GetActor() : nullptr;
 }   // end pick
 }   // end namespace
 
@@ -111,7 +202,8 @@ const vtkActor* pick( const cv::Point& p, vtkNew<vtkPropCollection> pickFrom,
 const vtkActor* RendererPicker::pickActor( const cv::Point& p,
                                            const std::vector<const vtkProp*>& possActors) const
 {
-    return pick( p, createPropCollection( possActors), _ren, _pointOrigin);
+    RenderTimer timer( _stats, "RendererPicker::pickActor", _ren);
+    return pick( p, createPropCollection( possActors), _ren, _stats, _pointOrigin, _ppicker);
 }   // end pickActor
 
 
@@ -122,16 +214,19 @@ const vtkActor* RendererPicker::pickActor( const cv::Point2f& p,
 
 Vec3f RendererPicker::pickPosition( const cv::Point& p) const
 {
+    RenderTimer timer( _stats, "RendererPicker::pickPosition", _ren);
     if ( !_isValidPoint( _ren, p))
         return Vec3f::Zero();
     const cv::Point np = changeOriginOfPoint( _ren, p, _pointOrigin);
-    vtkNew<vtkPropPicker> picker;   // Hardware accelerated - may not be accurate enough!
+    // Hardware accelerated - may not be accurate enough!
     Vec3f v = Vec3f::Zero();
-    if ( picker->Pick( np.x, np.y, 0, _ren))
+    SelectionTimer stimer( _stats);
+    if ( _ppicker->Pick( np.x, np.y, 0, _ren))
     {
-        const double* wpos = picker->GetPickPosition();
+        const double* wpos = _ppicker->GetPickPosition();
         v = Vec3f( (float)wpos[0], (float)wpos[1], (float)wpos[2]);
     }   // end if
+    _ren->Modified();   // The selection pass overwrites the frame buffer
     return v;
 }   // end pickPosition
 
@@ -144,18 +239,18 @@ Vec3f RendererPicker::pickPosition( const cv::Point2f& p) const
 
 bool RendererPicker::pickPosition( const vtkProp *actor, const cv::Point &p, Vec3f &v) const
 {
+    RenderTimer timer( _stats, "RendererPicker::pickPosition", _ren);
     if ( !actor || !_isValidPoint( _ren, p))
         return false;
     const cv::Point np = changeOriginOfPoint( _ren, p, _pointOrigin);
 
     bool found = false;
-    vtkNew<vtkCellPicker> picker;
-    picker->SetTolerance(_tolerance);
-    picker->PickFromListOn();
-    picker->AddPickList( const_cast<vtkProp*>(actor));
-    if ( picker->Pick( np.x, np.y, 0, _ren))
+    _updateLocator( actor);
+    _cpicker->InitializePickList();
+    _cpicker->AddPickList( const_cast<vtkProp*>(actor));
+    if ( _cpicker->Pick( np.x, np.y, 0, _ren))
     {
-        const double* wpos = picker->GetPickPosition();
+        const double* wpos = _cpicker->GetPickPosition();
         v = Vec3f( (float)wpos[0], (float)wpos[1], (float)wpos[2]);
         found = true;
     }   // end if
@@ -169,8 +264,85 @@ bool RendererPicker::pickPosition( const vtkProp *actor, const cv::Point2f &p, V
 }   // end pickPosition
 
 
+namespace {
+
+// Unproject the given (bottom left origin) display points using the renderer's current Z-buffer.
+size_t unprojectPoints( vtkRenderer *ren, RenderStats *stats, const std::vector<cv::Point> &pts,
+                        std::vector<Vec3f> &vs, std::vector<bool> &hits)
+{
+    const size_t n = pts.size();
+    vs.assign( n, Vec3f::Zero());
+    hits.assign( n, false);
+
+    cv::Mat_<float> zimg;
+    {
+        CaptureTimer ctimer( stats);
+        zimg = r3dvis::readZ( ren);    // Top left origin
+    }   // end capture
+    const int w = zimg.cols;
+    const int h = zimg.rows;
+
+    // Gather the homogeneous view coordinates of the points hitting geometry.
+    std::vector<size_t> idxs;
+    idxs.reserve(n);
+    Eigen::Matrix<double, 4, Eigen::Dynamic> vpts( 4, n);
+    for ( size_t i = 0; i < n; ++i)
+    {
+        const cv::Point &p = pts[i];
+        if ( !_isValidPoint( ren, p))
+            continue;
+        const float z = zimg( h - p.y - 1, p.x);
+        if ( z >= 1.0f)    // Background
+            continue;
+        const size_t j = idxs.size();
+        vpts(0,j) = 2.0 * (p.x + 0.5) / w - 1.0;
+        vpts(1,j) = 2.0 * (p.y + 0.5) / h - 1.0;
+        vpts(2,j) = z;
+        vpts(3,j) = 1.0;
+        idxs.push_back(i);
+    }   // end for
+
+    const size_t m = idxs.size();
+    if ( m == 0)
+        return 0;
+
+    const Eigen::Matrix4d pinv = r3dvis::compositeProjection( ren).inverse();
+    const Eigen::Matrix<double, 4, Eigen::Dynamic> wpts = pinv * vpts.leftCols(m);
+    const Eigen::Matrix<double, 3, Eigen::Dynamic> xyz = wpts.topRows<3>().array().rowwise() / wpts.row(3).array();
+    for ( size_t j = 0; j < m; ++j)
+    {
+        vs[idxs[j]] = xyz.col(j).cast<float>();
+        hits[idxs[j]] = true;
+    }   // end for
+    return m;
+}   // end unprojectPoints
+
+}   // end namespace
+
+
+size_t RendererPicker::pickPositions( const std::vector<cv::Point> &pts, std::vector<Vec3f> &vs, std::vector<bool> &hits) const
+{
+    RenderTimer timer( _stats, "RendererPicker::pickPositions", _ren);
+    std::vector<cv::Point> npts( pts.size());
+    for ( size_t i = 0; i < pts.size(); ++i)
+        npts[i] = changeOriginOfPoint( _ren, pts[i], _pointOrigin);
+    return unprojectPoints( _ren, _stats, npts, vs, hits);
+}   // end pickPositions
+
+
+size_t RendererPicker::pickPositions( const std::vector<cv::Point2f> &pts, std::vector<Vec3f> &vs, std::vector<bool> &hits) const
+{
+    RenderTimer timer( _stats, "RendererPicker::pickPositions", _ren);
+    std::vector<cv::Point> npts( pts.size());
+    for ( size_t i = 0; i < pts.size(); ++i)
+        npts[i] = changeOriginOfPoint( _ren, _toPxls( _ren, pts[i]), _pointOrigin);
+    return unprojectPoints( _ren, _stats, npts, vs, hits);
+}   // end pickPositions
+
+
 cv::Point RendererPicker::projectToImagePlane( const Vec3f& v) const
 {
+    RenderTimer timer( _stats, "RendererPicker::projectToImagePlane", _ren);
     vtkNew<vtkCoordinate> coordConverter;
     coordConverter->SetCoordinateSystemToWorld();
     coordConverter->SetValue( v[0], v[1], v[2]);
@@ -179,3 +351,292 @@ cv::Point RendererPicker::projectToImagePlane( const Vec3f& v) const
     return changeOriginOfPoint( _ren, p, _pointOrigin);
 }   // end projectToImagePlane
 
+
+
+namespace {
+
+// Depth test tolerance in Z-buffer units.
+const float DEPTH_TOLERANCE = 1e-4f;
+
+// Project the given homogeneous world points (as columns) returning display points
+// using the given point origin and optionally depth testing against the Z-buffer.
+void projectPoints( vtkRenderer *ren, RenderStats *stats, const Eigen::Matrix<double, 4, Eigen::Dynamic> &wpts,
+                    RendererPicker::PointOrigin po, std::vector<cv::Point> &pts, std::vector<bool> *occluded)
+{
+    const Eigen::Matrix<double, 4, Eigen::Dynamic> vpts = r3dvis::compositeProjection( ren) * wpts;
+    const Eigen::Array<double, 1, Eigen::Dynamic> iw = vpts.row(3).array().inverse();
+    const Eigen::Array<double, 3, Eigen::Dynamic> nvs = vpts.topRows<3>().array().rowwise() * iw;
+
+    const int w = ren->GetSize()[0];
+    const int h = ren->GetSize()[1];
+    const Eigen::Array<double, 1, Eigen::Dynamic> dx = (nvs.row(0) + 1.0) * (0.5 * w);
+    const Eigen::Array<double, 1, Eigen::Dynamic> dy = (nvs.row(1) + 1.0) * (0.5 * h);
+
+    // Points on or behind the camera plane (or too far out to fit an int) have no
+    // defined projection and are given the sentinel (-1,-1) which is outside the viewport.
+    const size_t n = size_t(wpts.cols());
+    std::vector<bool> valid( n, false);
+    pts.assign( n, cv::Point(-1,-1));
+    for ( size_t i = 0; i < n; ++i)
+    {
+        const double fx = floor(dx(i));
+        const double fy = floor(dy(i));
+        if ( !(iw(i) > 0) || !std::isfinite(fx) || !std::isfinite(fy) || fabs(fx) > INT_MAX/2 || fabs(fy) > INT_MAX/2)
+            continue;
+        valid[i] = true;
+        pts[i] = changeOriginOfPoint( ren, cv::Point( int(fx), int(fy)), po);
+    }   // end for
+
+    if ( !occluded)
+        return;
+
+    occluded->assign( n, true);
+    cv::Mat_<float> zimg;
+    {
+        CaptureTimer ctimer( stats);
+        zimg = r3dvis::readZ( ren);    // Top left origin
+    }   // end capture
+    for ( size_t i = 0; i < n; ++i)
+    {
+        if ( !valid[i])
+            continue;
+        const int x = int(floor(dx(i)));
+        const int y = int(floor(dy(i)));
+        if ( !_isValidPoint( ren, cv::Point(x,y)))  // Outside viewport
+            continue;
+        (*occluded)[i] = float(nvs(2,i)) > zimg( h - y - 1, x) + DEPTH_TOLERANCE;
+    }   // end for
+}   // end projectPoints
+
+}   // end namespace
+
+
+void RendererPicker::projectToImagePlane( const std::vector<Vec3f> &vs, std::vector<cv::Point> &pts, std::vector<bool> *occluded) const
+{
+    RenderTimer timer( _stats, "RendererPicker::projectToImagePlane", _ren);
+    const size_t n = vs.size();
+    Eigen::Matrix<double, 4, Eigen::Dynamic> wpts( 4, n);
+    for ( size_t i = 0; i < n; ++i)
+        wpts.col(i) << vs[i].cast<double>(), 1.0;
+    projectPoints( _ren, _stats, wpts, _pointOrigin, pts, occluded);
+}   // end projectToImagePlane
+
+
+void RendererPicker::projectToImagePlane( const r3d::MatX3f &vs, std::vector<cv::Point> &pts, std::vector<bool> *occluded) const
+{
+    RenderTimer timer( _stats, "RendererPicker::projectToImagePlane", _ren);
+    Eigen::Matrix<double, 4, Eigen::Dynamic> wpts( 4, vs.rows());
+    wpts.topRows<3>() = vs.transpose().cast<double>();
+    wpts.row(3).setOnes();
+    projectPoints( _ren, _stats, wpts, _pointOrigin, pts, occluded);
+}   // end projectToImagePlane
+
+
+namespace {
+
+// Get world space rays through the centres of the given (bottom left origin) display pixels.
+// Rays start at the camera position (or for parallel projection, level with it) rather than
+// on the near clipping plane since the clipping range may not have been reset for the current
+// scene and would otherwise miss geometry in front of it. Rays for points outside the viewport
+// are zero.
+void makeRays( vtkRenderer *ren, const std::vector<cv::Point> &pts, std::vector<Vec3f> &origins, std::vector<Vec3f> &dirs)
+{
+    const size_t n = pts.size();
+    const int w = ren->GetSize()[0];
+    const int h = ren->GetSize()[1];
+    Eigen::Matrix<double, 4, Eigen::Dynamic> vpts( 4, 2*n);
+    for ( size_t i = 0; i < n; ++i)
+    {
+        const double x = 2.0 * (pts[i].x + 0.5) / w - 1.0;
+        const double y = 2.0 * (pts[i].y + 0.5) / h - 1.0;
+        vpts.col(2*i) << x, y, 0.0, 1.0;
+        vpts.col(2*i+1) << x, y, 1.0, 1.0;
+    }   // end for
+
+    const Eigen::Matrix<double, 4, Eigen::Dynamic> wpts = r3dvis::compositeProjection( ren).inverse() * vpts;
+    const Eigen::Array<double, 1, Eigen::Dynamic> iw = wpts.row(3).array().inverse();
+    const Eigen::Matrix<double, 3, Eigen::Dynamic> xyz = (wpts.topRows<3>().array().rowwise() * iw).matrix();
+
+    vtkCamera *cam = ren->GetActiveCamera();
+    const Eigen::Vector3d cpos( cam->GetPosition());
+    const bool parallel = cam->GetParallelProjection() != 0;
+
+    origins.assign( n, Vec3f::Zero());
+    dirs.assign( n, Vec3f::Zero());
+    for ( size_t i = 0; i < n; ++i)
+    {
+        if ( !_isValidPoint( ren, pts[i]))
+            continue;
+        const Eigen::Vector3d d = xyz.col(2*i+1) - xyz.col(2*i);
+        Eigen::Vector3d o = cpos;
+        if ( parallel)  // Move the near point back along the ray until it's level with the camera
+        {
+            const Eigen::Vector3d nd = d.normalized();
+            o = xyz.col(2*i) - nd * nd.dot( xyz.col(2*i) - cpos);
+        }   // end if
+        origins[i] = o.cast<float>();
+        dirs[i] = (xyz.col(2*i+1) - o).cast<float>();
+    }   // end for
+}   // end makeRays
+
+}   // end namespace
+
+
+bool RendererPicker::pickFace( const MeshBVH &bvh, const cv::Point &p, MeshBVH::Hit &hit) const
+{
+    std::vector<MeshBVH::Hit> hits;
+    pickFaces( bvh, std::vector<cv::Point>( 1, p), hits);
+    hit = hits[0];
+    return hit.fid >= 0;
+}   // end pickFace
+
+
+bool RendererPicker::pickFace( const MeshBVH &bvh, const cv::Point2f &p, MeshBVH::Hit &hit) const
+{
+    return pickFace( bvh, _toPxls(_ren, p), hit);
+}   // end pickFace
+
+
+size_t RendererPicker::pickFaces( const MeshBVH &bvh, const std::vector<cv::Point> &pts, std::vector<MeshBVH::Hit> &hits) const
+{
+    RenderTimer timer( _stats, "RendererPicker::pickFaces", _ren);
+    std::vector<cv::Point> npts( pts.size());
+    for ( size_t i = 0; i < pts.size(); ++i)
+        npts[i] = changeOriginOfPoint( _ren, pts[i], _pointOrigin);
+    std::vector<Vec3f> origins, dirs;
+    makeRays( _ren, npts, origins, dirs);
+    // Zero length directions (points outside the viewport) are returned as misses.
+    return bvh.intersect( origins, dirs, hits);
+}   // end pickFaces
+
+
+size_t RendererPicker::pickFaces( const MeshBVH &bvh, const std::vector<cv::Point2f> &pts, std::vector<MeshBVH::Hit> &hits) const
+{
+    std::vector<cv::Point> ipts( pts.size());
+    for ( size_t i = 0; i < pts.size(); ++i)
+        ipts[i] = _toPxls( _ren, pts[i]);
+    return pickFaces( bvh, ipts, hits);
+}   // end pickFaces
+
+
+namespace {
+
+// Project the mesh's vertices (transformed by the actor's matrix) to top left origin pixels
+// setting inside[i] true for vertices in front of the camera and projecting inside the mask.
+void projectVerticesInto( vtkRenderer *ren, const vtkActor *actor, const r3d::Mesh &mesh,
+                          const cv::Mat_<byte> &mask, std::vector<bool> &inside)
+{
+    const int nv = int(mesh.numVtxs());
+    Eigen::Matrix<double, 4, Eigen::Dynamic> vpts( 4, nv);
+    for ( int vid = 0; vid < nv; ++vid)
+        vpts.col(vid) << mesh.uvtx(vid).cast<double>(), 1.0;
+
+    const r3d::Mat4f T = r3dvis::toEigen( const_cast<vtkActor*>(actor)->GetMatrix());
+    vpts = (r3dvis::compositeProjection( ren) * T.cast<double>()) * vpts;
+
+    const int w = mask.cols;
+    const int h = mask.rows;
+    inside.assign( nv, false);
+    for ( int vid = 0; vid < nv; ++vid)
+    {
+        const double iw = 1.0 / vpts(3,vid);
+        if ( iw <= 0) // Behind the camera
+            continue;
+        const int x = int(floor( (vpts(0,vid)*iw + 1.0) * (0.5 * w)));
+        const int y = h - 1 - int(floor( (vpts(1,vid)*iw + 1.0) * (0.5 * h)));
+        if ( x >= 0 && y >= 0 && x < w && y < h)
+            inside[vid] = mask( y, x) > 0;
+    }   // end for
+}   // end projectVerticesInto
+
+}   // end namespace
+
+
+size_t RendererPicker::pickArea( const vtkActor *actor, const r3d::Mesh &mesh, const cv::Rect &rect,
+                                 IntSet &fids, IntSet *vids, bool seeThrough) const
+{
+    const std::vector<cv::Point> poly = { rect.tl(), cv::Point( rect.x + rect.width - 1, rect.y),
+                                          rect.br() - cv::Point(1,1), cv::Point( rect.x, rect.y + rect.height - 1)};
+    return pickArea( actor, mesh, poly, fids, vids, seeThrough);
+}   // end pickArea
+
+
+size_t RendererPicker::pickArea( const vtkActor *actor, const r3d::Mesh &mesh, const std::vector<cv::Point> &lasso,
+                                 IntSet &fids, IntSet *vids, bool seeThrough) const
+{
+    RenderTimer timer( _stats, "RendererPicker::pickArea", _ren);
+    fids.clear();
+    if ( vids)
+        vids->clear();
+    if ( !mesh.hasSequentialIds())
+    {
+        std::cerr << "[ERROR] r3dvis::RendererPicker::pickArea: Mesh IDs must be in sequential order!" << std::endl;
+        return 0;
+    }   // end if
+    if ( lasso.size() < 3)
+        return 0;
+
+    // Rasterise the region into a top left origin mask the size of the viewport.
+    const int w = _ren->GetSize()[0];
+    const int h = _ren->GetSize()[1];
+    std::vector<cv::Point> poly( lasso);
+    if ( _pointOrigin == BOTTOM_LEFT)
+        for ( cv::Point &p : poly)
+            p.y = h - p.y - 1;
+    cv::Mat_<byte> mask = cv::Mat_<byte>::zeros( h, w);
+    cv::fillPoly( mask, std::vector<std::vector<cv::Point> >( 1, poly), cv::Scalar(255));
+
+    // Faces visible inside the region from the ID buffer.
+    IdBuffer ibuf;
+    {
+        SelectionTimer stimer( _stats);
+        ibuf = extractIds( _ren);
+    }   // end selection
+    const auto it = std::find( ibuf.props.begin(), ibuf.props.end(), actor);
+    const int nf = int(mesh.numFaces());
+    if ( it != ibuf.props.end())
+    {
+        const int aidx = int(it - ibuf.props.begin());
+        for ( int i = 0; i < h; ++i)
+        {
+            const byte *mrow = mask.ptr(i);
+            const int *prow = ibuf.propIds.ptr<int>(i);
+            const int *crow = ibuf.cellIds.ptr<int>(i);
+            for ( int j = 0; j < w; ++j)
+                if ( mrow[j] && prow[j] == aidx && crow[j] >= 0 && crow[j] < nf)
+                    fids.insert( crow[j]);
+        }   // end for
+    }   // end if
+
+    if ( !seeThrough && !vids)
+        return fids.size();
+
+    std::vector<bool> inside;
+    projectVerticesInto( _ren, actor, mesh, mask, inside);
+
+    if ( seeThrough)
+    {
+        for ( int fid = 0; fid < nf; ++fid)
+        {
+            const int *fvidxs = mesh.fvidxs(fid);
+            if ( inside[fvidxs[0]] || inside[fvidxs[1]] || inside[fvidxs[2]])
+                fids.insert( fid);
+        }   // end for
+        if ( vids)
+            for ( int vid = 0; vid < int(inside.size()); ++vid)
+                if ( inside[vid])
+                    vids->insert( vid);
+    }   // end if
+    else
+    {
+        for ( int fid : fids)
+        {
+            const int *fvidxs = mesh.fvidxs(fid);
+            for ( int k = 0; k < 3; ++k)
+                if ( inside[fvidxs[k]])
+                    vids->insert( fvidxs[k]);
+        }   // end for
+    }   // end else
+
+    return fids.size();
+}   // end pickArea
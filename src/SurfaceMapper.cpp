@@ -17,18 +17,81 @@
 
 #include <SurfaceMapper.h>
 #include <VtkTools.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkUnsignedShortArray.h>
 #include <climits>
-#include <cstdlib>
+#include <cstring>
 #include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
 using r3dvis::SurfaceMapper;
 using r3dvis::FaceSurfaceMapper;
 using r3dvis::VertexSurfaceMapper;
 using r3dvis::MetricFn;
+using r3dvis::BatchMetricFn;
+using r3dvis::Quantization;
 using r3d::Mesh;
 
-SurfaceMapper::SurfaceMapper( const MetricFn& fn, size_t d) : _mfn(fn), _ndims( std::max<size_t>(d, 1)) {}
+SurfaceMapper::SurfaceMapper( const MetricFn& fn, size_t d) : _mfn(fn), _ndims( std::max<size_t>(d, 1)), _nthreads(1) {}
+SurfaceMapper::SurfaceMapper( const BatchMetricFn& fn, size_t d) : _bfn(fn), _ndims( std::max<size_t>(d, 1)), _nthreads(1) {}
 VertexSurfaceMapper::VertexSurfaceMapper( const MetricFn& fn, size_t d) : SurfaceMapper( fn, d) {}
+VertexSurfaceMapper::VertexSurfaceMapper( const BatchMetricFn& fn, size_t d) : SurfaceMapper( fn, d) {}
 FaceSurfaceMapper::FaceSurfaceMapper( const MetricFn& fn, size_t d) : SurfaceMapper( fn, d) {}
+FaceSurfaceMapper::FaceSurfaceMapper( const BatchMetricFn& fn, size_t d) : SurfaceMapper( fn, d) {}
+
+
+namespace {
+const int MIN_PER_THREAD = 4096;    // Ranges shorter than this aren't worth a thread
+}   // end namespace
+
+
+void SurfaceMapper::setNumThreads( size_t n)
+{
+    if ( n == 0)
+        n = std::thread::hardware_concurrency();
+    _nthreads = std::max<size_t>( n, 1);
+}   // end setNumThreads
+
+
+void SurfaceMapper::_eval( int id0, int n, float *out) const
+{
+    const int nt = int(std::min<size_t>( _nthreads, std::max( 1, n / MIN_PER_THREAD)));
+    if ( nt <= 1)
+    {
+        _evalRange( id0, n, out);
+        return;
+    }   // end if
+
+    // Each thread writes to its own disjoint block of out.
+    const int chunk = (n + nt - 1) / nt;
+    std::vector<std::future<void> > futs;
+    for ( int i = chunk; i < n; i += chunk)
+    {
+        const int m = std::min( chunk, n - i);
+        futs.push_back( std::async( std::launch::async, [=](){ _evalRange( id0 + i, m, out + size_t(i)*dims());}));
+    }   // end for
+    _evalRange( id0, std::min( chunk, n), out);
+    for ( std::future<void> &f : futs)
+        f.get();
+}   // end _eval
+
+
+void SurfaceMapper::_evalRange( int id0, int n, float *out) const
+{
+    if ( _bfn)
+    {
+        _bfn( id0, n, out);
+        return;
+    }   // end if
+
+    const size_t nd = dims();
+    for ( int i = 0; i < n; ++i)
+        for ( size_t k = 0; k < nd; ++k)
+            *out++ = _mfn( id0 + i, k);
+}   // end _evalRange
 
 
 vtkSmartPointer<vtkFloatArray> SurfaceMapper::_initArray( const Mesh& mesh, const char *aname) const
@@ -57,14 +120,142 @@ vtkSmartPointer<vtkFloatArray> SurfaceMapper::makeArrayNoTx( const Mesh& mesh, c
 }   // end makeArrayNoTx
 
 
+vtkSmartPointer<vtkFloatArray> SurfaceMapper::makeArray( const vtkActor *actor, const Mesh& mesh, const char *aname) const
+{
+    vtkSmartPointer<vtkFloatArray> vals = _initArray(mesh, aname);
+    const vtkIntArray *pvmap = getPointVertexMap( actor);
+    if ( pvmap)
+        _makeArray( mesh, *pvmap, vals);
+    else
+        _makeArrayNoTx( mesh, vals);
+    return vals;
+}   // end makeArray
+
+
+Quantization::Quantization( float minv, float maxv, int bits)
+    : offset(minv), levels( bits > 8 ? 65536 : 256)
+{
+    assert( bits == 8 || bits == 16);
+    scale = maxv > minv ? (maxv - minv) / (levels - 2) : 1.0f;
+}   // end ctor
+
+
+int Quantization::level( float v) const
+{
+    if ( !std::isfinite(v))
+        return nanLevel();
+    const float q = roundf( (v - offset) / scale);
+    return int( std::min( std::max( q, 0.0f), float(levels - 2)));
+}   // end level
+
+
+void Quantization::apply( vtkMapper *mapper) const
+{
+    mapper->SetColorModeToMapScalars();
+    mapper->SetScalarRange( 0, levels - 2);
+    mapper->ScalarVisibilityOn();
+}   // end apply
+
+
+namespace {
+
+template <typename T>
+vtkSmartPointer<T> quantize( const std::vector<float> &vals, int nc, const vtkIntArray *tmap, const Quantization &q)
+{
+    using V = typename T::ValueType;
+    const vtkIdType nids = vtkIdType(vals.size()) / nc;
+
+    // Quantise the per ID values first so that the fan out is a plain gather of small values.
+    std::vector<V> qvals( vals.size());
+    for ( size_t i = 0; i < vals.size(); ++i)
+        qvals[i] = V( q.level( vals[i]));
+
+    vtkSmartPointer<T> arr = vtkSmartPointer<T>::New();
+    arr->SetNumberOfComponents( nc);
+    const vtkIdType nt = tmap ? tmap->GetNumberOfTuples() : nids;
+    arr->SetNumberOfTuples( nt);
+    V *out = arr->GetPointer(0);
+    if ( !tmap)
+        memcpy( out, qvals.data(), qvals.size()*sizeof(V));
+    else
+    {
+        const int *ids = const_cast<vtkIntArray*>(tmap)->GetPointer(0);
+        for ( vtkIdType i = 0; i < nt; ++i, out += nc)
+            memcpy( out, &qvals[size_t(ids[i])*nc], nc*sizeof(V));
+    }   // end else
+    return arr;
+}   // end quantize
+
+}   // end namespace
+
+
+vtkSmartPointer<vtkDataArray> SurfaceMapper::makeQuantizedArray( const vtkActor *actor, const Mesh &mesh,
+                                                                 const Quantization &q, const char *aname) const
+{
+    assert( mesh.hasSequentialIds());
+    const int n = _numIds( mesh);
+    std::vector<float> vals( size_t(n)*dims());
+    _eval( 0, n, vals.data());
+
+    vtkSmartPointer<vtkDataArray> arr;
+    if ( q.levels <= 256)
+        arr = quantize<vtkUnsignedCharArray>( vals, int(dims()), _tupleMap( actor), q);
+    else
+        arr = quantize<vtkUnsignedShortArray>( vals, int(dims()), _tupleMap( actor), q);
+    arr->SetName( aname);
+    return arr;
+}   // end makeQuantizedArray
+
+
+void SurfaceMapper::update( const Mesh& mesh, vtkFloatArray *vals, const IntSet &cids) const
+{
+    _update( mesh, vals, cids, false);
+}   // end update
+
+
+void SurfaceMapper::updateNoTx( const Mesh& mesh, vtkFloatArray *vals, const IntSet &cids) const
+{
+    _update( mesh, vals, cids, true);
+}   // end updateNoTx
+
+
+void SurfaceMapper::_update( const Mesh& mesh, vtkFloatArray *vals, const IntSet &cids, bool noTx) const
+{
+    assert( vals->GetNumberOfComponents() == int(dims()));
+    if ( cids.empty())
+        return;
+
+    // Evaluate runs of consecutive IDs together so batch metric functions get contiguous ranges.
+    std::vector<int> ids( cids.begin(), cids.end());
+    std::sort( ids.begin(), ids.end());
+    const size_t nd = dims();
+    std::vector<float> tvals( ids.size() * nd);
+    size_t i = 0;
+    while ( i < ids.size())
+    {
+        size_t j = i + 1;
+        while ( j < ids.size() && ids[j] == ids[j-1] + 1)
+            j++;
+        _eval( ids[i], int(j - i), &tvals[i*nd]);
+        i = j;
+    }   // end while
+
+    for ( i = 0; i < ids.size(); ++i)
+    {
+        if ( noTx)
+            _setTupleNoTx( mesh, vals, ids[i], &tvals[i*nd]);
+        else
+            _setTuple( mesh, vals, ids[i], &tvals[i*nd]);
+    }   // end for
+    vals->Modified();
+}   // end _update
+
+
 void FaceSurfaceMapper::_makeArray( const r3d::Mesh &mesh, vtkFloatArray *cvals) const
 {
-    const int nd = int(dims());
     const int nf = int(mesh.numFaces());
     cvals->SetNumberOfTuples( nf);
-    for ( int k = 0; k < nd; ++k)
-        for ( int fid = 0; fid < nf; ++fid)
-            cvals->SetComponent( fid, k, _mfn( fid, k));
+    _eval( 0, nf, cvals->GetPointer(0));    // Written straight into the array's buffer
 }   // end _makeArray
 
 
@@ -72,6 +263,24 @@ void FaceSurfaceMapper::_makeArrayNoTx( const r3d::Mesh &mesh, vtkFloatArray *cv
 { _makeArray(mesh, cvals);}
 
 
+void FaceSurfaceMapper::_makeArray( const r3d::Mesh &mesh, const vtkIntArray&, vtkFloatArray *cvals) const
+{ _makeArray(mesh, cvals);}
+
+
+int FaceSurfaceMapper::_numIds( const r3d::Mesh &mesh) const { return int(mesh.numFaces());}
+const vtkIntArray* FaceSurfaceMapper::_tupleMap( const vtkActor*) const { return nullptr;}
+
+
+void FaceSurfaceMapper::_setTuple( const r3d::Mesh&, vtkFloatArray *cvals, int fid, const float *v) const
+{
+    memcpy( cvals->GetPointer( vtkIdType(fid)*vtkIdType(dims())), v, dims()*sizeof(float));
+}   // end _setTuple
+
+
+void FaceSurfaceMapper::_setTupleNoTx( const r3d::Mesh &mesh, vtkFloatArray *cvals, int fid, const float *v) const
+{ _setTuple( mesh, cvals, fid, v);}
+
+
 // For vertex mapping, depending on how the actor's polydata have been created, there could be the
 // same number of points as there are vertices in the mesh (if texture mapping was not done) or
 // there could be three times the number of triangles (if texture mapping was done). In the first
@@ -80,12 +289,9 @@ void FaceSurfaceMapper::_makeArrayNoTx( const r3d::Mesh &mesh, vtkFloatArray *cv
 // be mapped to all of these duplicate corresponding points in the array.
 void VertexSurfaceMapper::_makeArrayNoTx( const r3d::Mesh &mesh, vtkFloatArray *cvals) const
 {
-    const int nd = int(dims());
     const int nv = int(mesh.numVtxs());
     cvals->SetNumberOfTuples( nv);
-    for ( int k = 0; k < nd; ++k)
-        for ( int vid = 0; vid < nv; ++vid)
-            cvals->SetComponent( vid, k, _mfn( vid, k));    // One-to-one mapping
+    _eval( 0, nv, cvals->GetPointer(0));    // One-to-one mapping
 }   // end _makeArrayNoTx
 
 
@@ -97,24 +303,73 @@ void VertexSurfaceMapper::_makeArray( const r3d::Mesh &mesh, vtkFloatArray *cval
     {
         const size_t nd = dims();
         const int nv = int(mesh.numVtxs());
-        float *vmap = (float*)malloc( nv*nd*sizeof(float));
-
-        // For each dimension store the per vertex value from the delegate fn
-        for ( size_t k = 0; k < nd; ++k)
-            for ( int vid = 0; vid < nv; ++vid)
-                vmap[nd*vid+k] = _mfn( vid, k);
+        std::lock_guard<std::mutex> lock( _scratchLock);
+        const float *vmap = _vertexValues( nv);
 
         const int nf = int(mesh.numFaces());
         cvals->SetNumberOfTuples( 3*nf);
-        int i = 0;
+        float *out = cvals->GetPointer(0);
+        const size_t tbytes = nd*sizeof(float);
         for ( int fid = 0; fid < nf; ++fid)
         {
             const int* fvidxs = mesh.fvidxs(fid);
-            cvals->SetTuple( i++, &vmap[nd*fvidxs[0]]);
-            cvals->SetTuple( i++, &vmap[nd*fvidxs[1]]);
-            cvals->SetTuple( i++, &vmap[nd*fvidxs[2]]);
+            for ( int j = 0; j < 3; ++j, out += nd)
+                memcpy( out, &vmap[nd*fvidxs[j]], tbytes);
         }   // end for
-
-        free(vmap);
     }   // end else
 }   // end _makeArray
+
+
+int VertexSurfaceMapper::_numIds( const r3d::Mesh &mesh) const { return int(mesh.numVtxs());}
+const vtkIntArray* VertexSurfaceMapper::_tupleMap( const vtkActor *actor) const { return getPointVertexMap( actor);}
+
+
+const float* VertexSurfaceMapper::_vertexValues( int nv) const
+{
+    const size_t n = size_t(nv)*dims();
+    if ( _scratch.size() < n)   // Only grows so repeated builds don't reallocate
+        _scratch.resize( n);
+    _eval( 0, nv, _scratch.data());
+    return _scratch.data();
+}   // end _vertexValues
+
+
+void VertexSurfaceMapper::_makeArray( const r3d::Mesh &mesh, const vtkIntArray &pvmap, vtkFloatArray *cvals) const
+{
+    const size_t nd = dims();
+    std::lock_guard<std::mutex> lock( _scratchLock);
+    const float *vvals = _vertexValues( int(mesh.numVtxs()));
+    const vtkIdType np = pvmap.GetNumberOfTuples();
+    cvals->SetNumberOfTuples( np);
+    const int *vids = const_cast<vtkIntArray&>(pvmap).GetPointer(0);
+    float *out = cvals->GetPointer(0);
+    const size_t tbytes = nd*sizeof(float);
+    for ( vtkIdType i = 0; i < np; ++i, out += nd)
+        memcpy( out, &vvals[nd*vids[i]], tbytes);
+}   // end _makeArray
+
+
+void VertexSurfaceMapper::_setTupleNoTx( const r3d::Mesh&, vtkFloatArray *cvals, int vid, const float *v) const
+{
+    memcpy( cvals->GetPointer( vtkIdType(vid)*vtkIdType(dims())), v, dims()*sizeof(float));
+}   // end _setTupleNoTx
+
+
+void VertexSurfaceMapper::_setTuple( const r3d::Mesh &mesh, vtkFloatArray *cvals, int vid, const float *v) const
+{
+    if ( !mesh.hasMaterials())
+    {
+        _setTupleNoTx( mesh, cvals, vid, v);
+        return;
+    }   // end if
+
+    // Fan out to the duplicated point of each face using the vertex (see _makeArray).
+    const size_t tbytes = dims()*sizeof(float);
+    for ( int fid : mesh.faces(vid))
+    {
+        const int* fvidxs = mesh.fvidxs(fid);
+        for ( int j = 0; j < 3; ++j)
+            if ( fvidxs[j] == vid)
+                memcpy( cvals->GetPointer( vtkIdType(3*fid + j)*vtkIdType(dims())), v, tbytes);
+    }   // end for
+}   // end _setTuple
@@ -0,0 +1,162 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <SurfaceMapperSet.h>
+#include <VtkTools.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <cstring>
+#include <cassert>
+using r3dvis::SurfaceMapperSet;
+
+
+SurfaceMapperSet::SurfaceMapperSet() : _nthreads(1) {}
+
+
+void SurfaceMapperSet::add( const std::string &name, const VMapper &m)
+{
+    assert(m);
+    _vmappers.push_back( std::make_pair( name, m));
+}   // end add
+
+
+void SurfaceMapperSet::add( const std::string &name, const FMapper &m)
+{
+    assert(m);
+    _fmappers.push_back( std::make_pair( name, m));
+}   // end add
+
+
+void SurfaceMapperSet::setNumThreads( size_t n)
+{
+    if ( n == 0)
+        n = std::thread::hardware_concurrency();
+    _nthreads = std::max<size_t>( n, 1);
+}   // end setNumThreads
+
+
+void SurfaceMapperSet::_forEach( size_t n, const std::function<void(size_t)> &fn) const
+{
+    const size_t nt = std::min( _nthreads, n);
+    if ( nt <= 1)
+    {
+        for ( size_t i = 0; i < n; ++i)
+            fn(i);
+        return;
+    }   // end if
+
+    // Threads take the next mapper as they finish since metric costs vary a lot.
+    std::atomic<size_t> next(0);
+    std::vector<std::future<void> > futs;
+    for ( size_t t = 0; t < nt; ++t)
+        futs.push_back( std::async( std::launch::async, [&](){ for ( size_t i = next++; i < n; i = next++) fn(i);}));
+    for ( std::future<void> &f : futs)
+        f.get();
+}   // end _forEach
+
+
+std::vector<vtkSmartPointer<vtkFloatArray> > SurfaceMapperSet::makeArrays( const vtkActor *actor, const r3d::Mesh &mesh) const
+{
+    assert( mesh.hasSequentialIds());
+    const size_t nvm = _vmappers.size();
+    const size_t nfm = _fmappers.size();
+    std::vector<vtkSmartPointer<vtkFloatArray> > arrs( nvm + nfm);
+    for ( size_t i = 0; i < arrs.size(); ++i)
+    {
+        arrs[i] = vtkSmartPointer<vtkFloatArray>::New();
+        const bool isv = i < nvm;
+        arrs[i]->SetName( isv ? _vmappers[i].first.c_str() : _fmappers[i-nvm].first.c_str());
+        arrs[i]->SetNumberOfComponents( int(isv ? _vmappers[i].second->dims() : _fmappers[i-nvm].second->dims()));
+    }   // end for
+
+    const vtkIntArray *pvmap = getPointVertexMap( actor);
+    const int nv = int(mesh.numVtxs());
+    const int nf = int(mesh.numFaces());
+
+    // Evaluate every metric once per vertex/face. Face metrics and vertex metrics on actors
+    // without a point map go straight into their arrays; the others into scratch space.
+    std::vector<std::vector<float> > vvals( pvmap ? nvm : 0);
+    _forEach( nvm + nfm, [&]( size_t i)
+    {
+        if ( i >= nvm)
+        {
+            arrs[i]->SetNumberOfTuples( nf);
+            _fmappers[i-nvm].second->evaluate( mesh, arrs[i]->GetPointer(0));
+        }   // end if
+        else if ( !pvmap)
+        {
+            arrs[i]->SetNumberOfTuples( nv);
+            _vmappers[i].second->evaluate( mesh, arrs[i]->GetPointer(0));
+        }   // end else if
+        else
+        {
+            vvals[i].resize( size_t(nv) * _vmappers[i].second->dims());
+            _vmappers[i].second->evaluate( mesh, vvals[i].data());
+        }   // end else
+    });
+
+    if ( !pvmap || nvm == 0)
+        return arrs;
+
+    // Single traversal of the point map fanning out to all vertex arrays together.
+    const vtkIdType np = pvmap->GetNumberOfTuples();
+    std::vector<float*> outs( nvm);
+    std::vector<size_t> nds( nvm);
+    for ( size_t i = 0; i < nvm; ++i)
+    {
+        arrs[i]->SetNumberOfTuples( np);
+        outs[i] = arrs[i]->GetPointer(0);
+        nds[i] = _vmappers[i].second->dims();
+    }   // end for
+
+    const int *vids = const_cast<vtkIntArray*>(pvmap)->GetPointer(0);
+    for ( vtkIdType j = 0; j < np; ++j)
+    {
+        const size_t vid = size_t(vids[j]);
+        for ( size_t i = 0; i < nvm; ++i)
+        {
+            const size_t nd = nds[i];
+            memcpy( outs[i], &vvals[i][vid*nd], nd*sizeof(float));
+            outs[i] += nd;
+        }   // end for
+    }   // end for
+
+    return arrs;
+}   // end makeArrays
+
+
+size_t SurfaceMapperSet::addArrays( vtkActor *actor, const r3d::Mesh &mesh) const
+{
+    vtkPolyData *pd = getPolyData( actor);
+    if ( !pd)
+        return 0;
+
+    const std::vector<vtkSmartPointer<vtkFloatArray> > arrs = makeArrays( actor, mesh);
+    const size_t nvm = _vmappers.size();
+    for ( size_t i = 0; i < arrs.size(); ++i)
+    {
+        if ( i < nvm)
+            pd->GetPointData()->AddArray( arrs[i]);   // Replaces same named array
+        else
+            pd->GetCellData()->AddArray( arrs[i]);
+    }   // end for
+    return arrs.size();
+}   // end addArrays
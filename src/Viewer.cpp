@@ -18,11 +18,14 @@
 #include <Viewer.h>
 #include <VtkTools.h>
 #include <vtkFollower.h>
+#include <algorithm>
 using r3dvis::Viewer;
+using r3dvis::RenderTimer;
+using r3dvis::CaptureTimer;
 
 Viewer::Ptr Viewer::create( bool offscreen) { return Ptr( new Viewer( offscreen), [](Viewer* d){delete d;});}
 
-Viewer::Viewer( bool offscreen)
+Viewer::Viewer( bool offscreen) : _dirty(true), _renderedMTime(0)
 {
     _renWin->SetOffScreenRendering(offscreen);
     _renWin->SetPointSmoothing( false);
@@ -157,16 +160,74 @@ cv::Size Viewer::size() const
     return cv::Size( sz[0], sz[1]);
 }   // end size
 
-void Viewer::updateRender() { _renWin->Render();}
 
-cv::Mat_<cv::Vec3b> Viewer::extractBGR()
+
+vtkMTimeType Viewer::_sceneMTime() const
+{
+    vtkMTimeType mtime = std::max( _renWin->GetMTime(), _ren->GetMTime());
+    mtime = std::max( mtime, _ren->GetActiveCamera()->GetMTime());
+
+    vtkCollectionSimpleIterator it;
+    vtkLightCollection *lights = _ren->GetLights();
+    lights->InitTraversal( it);
+    while ( vtkLight *light = lights->GetNextLight( it))
+        mtime = std::max( mtime, light->GetMTime());
+
+    vtkPropCollection *props = _ren->GetViewProps();
+    props->InitTraversal( it);
+    while ( vtkProp *prop = props->GetNextProp( it))
+        mtime = std::max( mtime, prop->GetRedrawMTime());
+
+    return mtime;
+}   // end _sceneMTime
+
+
+bool Viewer::isDirty() const { return _dirty || _sceneMTime() > _renderedMTime;}
+
+
+void Viewer::updateRender()
 {
+    RenderTimer timer( &_stats, "Viewer::render", _ren);
+    _renWin->Render();
+    if ( _stats.enabled())
+        _stats.addRender( _ren->GetLastRenderTimeInSeconds() * 1000);
+    // Stamp after rendering since rendering can itself modify things (e.g. followers and headlights).
+    _renderedMTime = _sceneMTime();
+    _dirty = false;
+}   // end updateRender
+
+
+bool Viewer::renderIfDirty()
+{
+    if ( !isDirty())
+        return false;
     updateRender();
+    return true;
+}   // end renderIfDirty
+
+
+cv::Mat_<cv::Vec3b> Viewer::extractBGR()
+{
+    RenderTimer timer( &_stats, "Viewer::extractBGR", _ren);
+    renderIfDirty();
+    CaptureTimer ctimer( &_stats);
     return r3dvis::extractBGR( _renWin);
 }   // end extractBGR
 
 cv::Mat_<float> Viewer::extractZ()
 {
-    updateRender();
+    RenderTimer timer( &_stats, "Viewer::extractZ", _ren);
+    renderIfDirty();
+    CaptureTimer ctimer( &_stats);
     return r3dvis::extractZ( _renWin);
 }   // end extractZ
+
+r3dvis::IdBuffer Viewer::extractIds()
+{
+    RenderTimer timer( &_stats, "Viewer::extractIds", _ren);
+    // No need to render first since the selector does its own render passes.
+    SelectionTimer stimer( &_stats);
+    r3dvis::IdBuffer ibuf = r3dvis::extractIds( _ren);
+    _dirty = true;  // Selection passes overwrite the frame buffer
+    return ibuf;
+}   // end extractIds
@@ -24,6 +24,7 @@
 #include <vtkCellArray.h>
 #include <vtkFloatArray.h>
 #include <vtkPointData.h>
+#include <vtkFieldData.h>
 using r3dvis::VtkActorCreator;
 using r3d::Mesh;
 using r3d::Vec3f;
@@ -406,6 +407,9 @@ vtkSmartPointer<vtkActor> VtkActorCreator::generateActor( const Mesh& model)
     uvs->SetNumberOfTuples( NP);
     uvs->SetName( "TCoords_0");
 
+    // Map of points to mesh vertices so per vertex arrays can be made by a single gather.
+    vtkSmartPointer<vtkIntArray> pvmap = r3dvis::makePointVertexMap( model);
+
     /*/ TMP
     // We need to map vertex normals to the texture mapped points. We can't use VTKs built in normal generator algorithm
     // directly on the cell array being populated here because this expects it to be connected with common vertex IDs
@@ -457,6 +461,7 @@ vtkSmartPointer<vtkActor> VtkActorCreator::generateActor( const Mesh& model)
     pd->SetPoints( points);
     pd->SetPolys( faces);
     pd->GetPointData()->SetTCoords( uvs);
+    pd->GetFieldData()->AddArray( pvmap);
     //pd->GetPointData()->SetNormals( nrm);  // Required for interpolated shading   // TMP
 
     vtkSmartPointer<vtkActor> actor = makeActor(pd);
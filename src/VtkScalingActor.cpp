@@ -33,6 +33,10 @@ VtkScalingActor::VtkScalingActor( vtkPolyDataAlgorithm* src)
     _glyph->SetInputConnection(_d2cam->GetOutputPort());
     setFixedScale(false);
 
+    // The single point is updated in place by setPosition.
+    _points->SetNumberOfPoints(1);
+    _pset->SetPoints( _points);
+    _d2cam->SetInputData( _pset);
     setPosition( Vec3f::Zero());
 
     // Create the actor
@@ -88,11 +92,8 @@ bool VtkScalingActor::visible() const { return _actor->GetVisibility() != 0;}
 void VtkScalingActor::setPosition( const Vec3f& v)
 {
     _pos = v;
-    vtkNew<vtkPolyData> pointSet;
-    vtkNew<vtkPoints> points;
-    points->InsertPoint( 0, &std::vector<double>({v[0], v[1], v[2]})[0]);
-    pointSet->SetPoints( points);
-    _d2cam->SetInputData( pointSet);
+    _points->SetPoint( 0, v[0], v[1], v[2]);
+    _points->Modified();
 }   // end setPosition
 
 
@@ -0,0 +1,279 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <VtkScalingActorSet.h>
+#include <vtkPointData.h>
+#include <VtkTools.h>
+#include <vtkProperty.h>
+#include <iostream>
+#include <cassert>
+#include <cmath>
+using r3dvis::VtkScalingActorSet;
+using r3dvis::Vec3f;
+
+namespace {
+const char *COLOURS_NAME = "Colours";
+const char *MASK_NAME = "Visible";
+}   // end namespace
+
+
+VtkScalingActorSet::VtkScalingActorSet( vtkPolyDataAlgorithm* src) : _src(src)
+{
+    _colours->SetName( COLOURS_NAME);
+    _colours->SetNumberOfComponents(4);
+    _mask->SetName( MASK_NAME);
+    _pickable->SetName( "Pickable");
+
+    _pset->SetPoints( _points);
+    _pset->GetPointData()->AddArray( _colours);
+    _pset->GetPointData()->AddArray( _mask);
+    _d2cam->SetInputData( _pset);
+
+    // Glyphs are instanced and scaled on rendering updates by the DistanceToCamera array.
+    _mapper->SetSourceConnection( src->GetOutputPort());
+    _mapper->SetInputConnection( _d2cam->GetOutputPort());
+    _mapper->SetScaleArray( "DistanceToCamera");
+    _mapper->SetScaleModeToScaleByMagnitude();
+    _mapper->SetMasking( true);
+    _mapper->SetMaskArray( MASK_NAME);
+    _mapper->SetScalarModeToUsePointFieldData();
+    _mapper->SelectColorArray( COLOURS_NAME);
+    _mapper->SetColorModeToDirectScalars();
+    _mapper->ScalarVisibilityOn();
+    setFixedScale(false);
+    _actor->SetMapper( _mapper);
+
+    // Ambient lighting only
+    vtkProperty* property = _actor->GetProperty();
+    property->SetAmbient(1.0);
+    property->SetDiffuse(0.0);
+    property->SetSpecular(0.0);
+}   // end ctor
+
+
+void VtkScalingActorSet::setRenderer( vtkRenderer* ren) { _d2cam->SetRenderer( ren);}
+vtkRenderer* VtkScalingActorSet::renderer() const { return _d2cam->GetRenderer();}
+
+void VtkScalingActorSet::setFixedScale( bool v) { _mapper->SetScaling(v);}
+bool VtkScalingActorSet::fixedScale() const { return _mapper->GetScaling();}
+
+void VtkScalingActorSet::setScaleFactor( double f) { _mapper->SetScaleFactor(f);}
+double VtkScalingActorSet::scaleFactor() const { return _mapper->GetScaleFactor();}
+
+void VtkScalingActorSet::setOpacity( double a) { _actor->GetProperty()->SetOpacity(a);}
+double VtkScalingActorSet::opacity() const { return _actor->GetProperty()->GetOpacity();}
+
+
+void VtkScalingActorSet::_modified()
+{
+    _points->Modified();
+    _pset->Modified();
+}   // end _modified
+
+
+int VtkScalingActorSet::add( const Vec3f &v, const cv::Vec4b &c)
+{
+    const int i = int(_points->InsertNextPoint( v[0], v[1], v[2]));
+    _colours->InsertNextTypedTuple( &c[0]);
+    _mask->InsertNextValue(1);
+    _pickable->InsertNextValue(1);
+    _modified();
+    return i;
+}   // end add
+
+
+void VtkScalingActorSet::setPositions( const std::vector<Vec3f> &vs)
+{
+    const int n = int(vs.size());
+    const int n0 = size();
+    _points->SetNumberOfPoints( n);
+    _colours->SetNumberOfTuples( n);
+    _mask->SetNumberOfTuples( n);
+    _pickable->SetNumberOfTuples( n);
+    const uint8_t white[4] = {255,255,255,255};
+    for ( int i = n0; i < n; ++i)
+    {
+        _colours->SetTypedTuple( i, white);
+        _mask->SetValue( i, 1);
+        _pickable->SetValue( i, 1);
+    }   // end for
+    for ( int i = 0; i < n; ++i)
+        _points->SetPoint( i, vs[i][0], vs[i][1], vs[i][2]);
+    _modified();
+}   // end setPositions
+
+
+void VtkScalingActorSet::clear() { setPositions( std::vector<Vec3f>());}
+
+
+void VtkScalingActorSet::setPosition( int i, const Vec3f &v)
+{
+    assert( i >= 0 && i < size());
+    _points->SetPoint( i, v[0], v[1], v[2]);
+    _modified();
+}   // end setPosition
+
+
+Vec3f VtkScalingActorSet::position( int i) const
+{
+    double p[3];
+    _points->GetPoint( i, p);
+    return Vec3f( float(p[0]), float(p[1]), float(p[2]));
+}   // end position
+
+
+void VtkScalingActorSet::setColour( int i, const cv::Vec4b &c)
+{
+    assert( i >= 0 && i < size());
+    _colours->SetTypedTuple( i, &c[0]);
+    _colours->Modified();
+}   // end setColour
+
+
+cv::Vec4b VtkScalingActorSet::colour( int i) const
+{
+    cv::Vec4b c;
+    _colours->GetTypedTuple( i, &c[0]);
+    return c;
+}   // end colour
+
+
+void VtkScalingActorSet::setVisible( int i, bool v)
+{
+    assert( i >= 0 && i < size());
+    _mask->SetValue( i, v ? 1 : 0);
+    _mask->Modified();
+}   // end setVisible
+
+
+bool VtkScalingActorSet::visible( int i) const { return _mask->GetValue(i) != 0;}
+
+void VtkScalingActorSet::setPickable( int i, bool v) { _pickable->SetValue( i, v ? 1 : 0);}
+bool VtkScalingActorSet::pickable( int i) const { return _pickable->GetValue(i) != 0;}
+
+
+int VtkScalingActorSet::pickMarker( const RendererPicker &picker, const cv::Point &p, int maxDist) const
+{
+    if ( !_actor->GetVisibility() || !_actor->GetPickable())
+        return -1;
+    if ( !renderer())
+    {
+        std::cerr << "[ERROR] r3dvis::VtkScalingActorSet::pickMarker: Renderer not set!" << std::endl;
+        return -1;
+    }   // end if
+
+    const int n = size();
+    std::vector<Vec3f> vs;
+    std::vector<int> idxs;
+    vs.reserve(n);
+    idxs.reserve(n);
+    for ( int i = 0; i < n; ++i)
+    {
+        if ( visible(i) && pickable(i))
+        {
+            vs.push_back( position(i));
+            idxs.push_back(i);
+        }   // end if
+    }   // end for
+
+    std::vector<cv::Point> pts;
+    picker.projectToImagePlane( vs, pts);
+    std::vector<bool> occluded;
+    _depthTest( idxs, occluded);
+
+    int best = -1;
+    int bestDist = maxDist*maxDist;
+    for ( size_t j = 0; j < pts.size(); ++j)
+    {
+        if ( occluded[j])
+            continue;
+        const int dx = pts[j].x - p.x;
+        const int dy = pts[j].y - p.y;
+        const int d = dx*dx + dy*dy;
+        if ( d <= bestDist)
+        {
+            bestDist = d;
+            best = idxs[j];
+        }   // end if
+    }   // end for
+    return best;
+}   // end pickMarker
+
+
+double VtkScalingActorSet::_sourceRadius() const
+{
+    double b[6];
+    _src->Update();
+    _src->GetOutput()->GetBounds(b);
+    return 0.5 * sqrt( (b[1]-b[0])*(b[1]-b[0]) + (b[3]-b[2])*(b[3]-b[2]) + (b[5]-b[4])*(b[5]-b[4]));
+}   // end _sourceRadius
+
+
+double VtkScalingActorSet::_glyphScale( vtkDataArray *d2c, int i) const
+{
+    if ( !fixedScale())
+        return std::max( 1.0, scaleFactor());
+    // Scaled glyphs use the distance to camera array from the most recent render.
+    const double d = d2c && i < d2c->GetNumberOfTuples() ? d2c->GetTuple1(i) : 1.0;
+    return scaleFactor() * d;
+}   // end _glyphScale
+
+
+void VtkScalingActorSet::_depthTest( const std::vector<int> &idxs, std::vector<bool> &occluded) const
+{
+    // The Z-buffer includes the marker glyphs themselves whose front surfaces are nearer the camera
+    // than their centres, so a marker is only occluded if the surface seen at its centre's pixel is
+    // nearer the camera than the marker's centre by more than the marker glyph's radius.
+    vtkRenderer *ren = renderer();
+    const size_t n = idxs.size();
+    occluded.assign( n, true);
+    const cv::Mat_<float> zimg = readZ( ren);  // Top left origin
+    const int w = zimg.cols;
+    const int h = zimg.rows;
+    const Eigen::Matrix4d P = compositeProjection( ren);
+    const Eigen::Matrix4d Pinv = P.inverse();
+    vtkCamera *cam = ren->GetActiveCamera();
+    const Eigen::Vector3d cpos = Eigen::Map<const Eigen::Vector3d>( cam->GetPosition());
+    const Eigen::Vector3d cdir = Eigen::Map<const Eigen::Vector3d>( cam->GetDirectionOfProjection()).normalized();
+    const double srcRadius = _sourceRadius();
+    vtkDataArray *d2c = _d2cam->GetOutput()->GetPointData()->GetArray( "DistanceToCamera");
+
+    for ( size_t j = 0; j < n; ++j)
+    {
+        const Eigen::Vector3d v = position( idxs[j]).cast<double>();
+        const Eigen::Vector4d vp = P * v.homogeneous();
+        if ( !(vp[3] > 0) || !std::isfinite(vp[3]))   // On or behind the camera plane
+            continue;
+        const double nx = vp[0] / vp[3];
+        const double ny = vp[1] / vp[3];
+        const double fx = floor( (nx + 1.0) * (0.5 * w));
+        const double fy = floor( (ny + 1.0) * (0.5 * h));
+        if ( !std::isfinite(fx) || !std::isfinite(fy) || fx < 0 || fy < 0 || fx >= w || fy >= h)
+            continue;
+        const float z = zimg( h - int(fy) - 1, int(fx));
+        if ( z >= 1.0f)    // Nothing rendered at the pixel
+        {
+            occluded[j] = false;
+            continue;
+        }   // end if
+
+        const Eigen::Vector4d q = Pinv * Eigen::Vector4d( nx, ny, z, 1.0);
+        const double surfDepth = (q.head<3>() / q[3] - cpos).dot(cdir);
+        const double markerDepth = (v - cpos).dot(cdir);
+        occluded[j] = surfDepth < markerDepth - 1.01 * srcRadius * _glyphScale( d2c, idxs[j]);
+    }   // end for
+}   // end _depthTest
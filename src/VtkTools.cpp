@@ -26,6 +26,13 @@
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkMatrixToLinearTransform.h>
+#include <vtkOpenGLHardwareSelector.h>
+#include <vtkObjectFactory.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkFieldData.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
 #include <cassert>
 using r3dvis::Vec3f;
 using r3dvis::byte;
@@ -349,6 +356,190 @@ cv::Mat_<float> r3dvis::extractZ( vtkRenderWindow *rwin)
 }   // end extractZ
 
 
+namespace {
+
+// A hardware selector whose selection passes only render the props in a given set.
+// The props themselves aren't touched (e.g. hidden) so their modification times are kept.
+class SubsetSelector : public vtkOpenGLHardwareSelector
+{
+public:
+    static SubsetSelector* New();
+    vtkTypeMacro( SubsetSelector, vtkOpenGLHardwareSelector);
+
+    const std::unordered_set<const vtkProp*> *subset = nullptr;
+
+    int Render( vtkRenderer *ren, vtkProp **props, int nprops) override
+    {
+        std::vector<vtkProp*> keep;
+        keep.reserve( nprops);
+        for ( int i = 0; i < nprops; ++i)
+            if ( subset->count( props[i]) > 0)
+                keep.push_back( props[i]);
+        return Superclass::Render( ren, keep.data(), int(keep.size()));
+    }   // end Render
+};  // end class
+
+vtkStandardNewMacro( SubsetSelector);
+
+
+r3dvis::IdBuffer captureIds( vtkRenderer *ren, vtkHardwareSelector *selector)
+{
+    r3dvis::IdBuffer ibuf;
+    const int *org = ren->GetOrigin();
+    const int *sz = ren->GetSize();
+    const int w = sz[0];
+    const int h = sz[1];
+    ibuf.cellIds = cv::Mat_<int>( h, w, -1);
+    ibuf.propIds = cv::Mat_<int>( h, w, -1);
+    if ( w <= 0 || h <= 0)
+        return ibuf;
+
+    selector->SetRenderer( ren);
+    selector->SetFieldAssociation( vtkDataObject::FIELD_ASSOCIATION_CELLS);
+    selector->SetArea( org[0], org[1], org[0]+w-1, org[1]+h-1);
+    const bool captured = selector->CaptureBuffers() != 0;
+    ren->Modified();    // The selection passes overwrite the frame buffer
+    if ( !captured)
+    {
+        std::cerr << "[WARNING] r3dvis::extractIds: Unable to capture selection buffers!" << std::endl;
+        return ibuf;
+    }   // end if
+
+    std::unordered_map<const vtkProp*, int> pidxs;
+    unsigned int inpos[2];
+    unsigned int outpos[2];
+    for ( int i = 0; i < h; ++i)
+    {
+        int *cellRow = ibuf.cellIds.ptr<int>(h-i-1);    // Flip vertically for OpenCV
+        int *propRow = ibuf.propIds.ptr<int>(h-i-1);
+        inpos[1] = unsigned(org[1] + i);
+        for ( int j = 0; j < w; ++j)
+        {
+            inpos[0] = unsigned(org[0] + j);
+            const vtkHardwareSelector::PixelInformation info = selector->GetPixelInformation( inpos, 0, outpos);
+            if ( !info.Valid || !info.Prop)
+                continue;
+            auto it = pidxs.find( info.Prop);
+            if ( it == pidxs.end())
+            {
+                it = pidxs.insert( std::make_pair( info.Prop, int(ibuf.props.size()))).first;
+                ibuf.props.push_back( info.Prop);
+            }   // end if
+            propRow[j] = it->second;
+            cellRow[j] = int(info.AttributeID);
+        }   // end for
+    }   // end for
+
+    selector->ClearBuffers();
+    return ibuf;
+}   // end captureIds
+
+}   // end namespace
+
+
+r3dvis::IdBuffer r3dvis::extractIds( vtkRenderer *ren)
+{
+    vtkNew<vtkHardwareSelector> selector;
+    return captureIds( ren, selector);
+}   // end extractIds
+
+
+r3dvis::IdBuffer r3dvis::extractIds( vtkRenderer *ren, const std::unordered_set<const vtkProp*> &props)
+{
+    vtkNew<SubsetSelector> selector;
+    selector->subset = &props;
+    return captureIds( ren, selector);
+}   // end extractIds
+
+
+cv::Mat_<cv::Vec3b> r3dvis::readBGR( vtkRenderer *ren)
+{
+    const int *org = ren->GetOrigin();
+    const int *sz = ren->GetSize();
+    const int w = sz[0];
+    const int h = sz[1];
+    cv::Mat_<cv::Vec3b> img( h, w);
+    if ( w <= 0 || h <= 0)
+        return img;
+
+    vtkNew<vtkUnsignedCharArray> rgb;
+    ren->GetRenderWindow()->GetPixelData( org[0], org[1], org[0]+w-1, org[1]+h-1, 1/*front*/, rgb);
+    const byte *pxls = rgb->GetPointer(0);
+    for ( int i = 0; i < h; ++i)
+    {
+        cv::Vec3b *imgRow = img.ptr<cv::Vec3b>(h-i-1); // Flip vertically for OpenCV
+        const byte *row = &pxls[3*size_t(i)*w];
+        for ( int j = 0; j < w; ++j)
+            imgRow[j] = cv::Vec3b( row[3*j+2], row[3*j+1], row[3*j]);  // RGB to BGR
+    }   // end for
+    return img;
+}   // end readBGR
+
+
+bool r3dvis::readBGR( vtkRenderer *ren, cv::Mat_<cv::Vec3b> &dst)
+{
+    const int *org = ren->GetOrigin();
+    const int *sz = ren->GetSize();
+    const int w = sz[0];
+    const int h = sz[1];
+    if ( w <= 0 || h <= 0 || dst.cols != w || dst.rows != h || !dst.isContinuous())
+        return false;
+
+    // Wrap the destination so GetPixelData writes straight into it (the array doesn't take ownership).
+    byte *pxls = dst.ptr<byte>();
+    vtkNew<vtkUnsignedCharArray> rgb;
+    rgb->SetNumberOfComponents(3);
+    rgb->SetArray( pxls, vtkIdType(3*size_t(w)*h), 1/*save*/);
+    ren->GetRenderWindow()->GetPixelData( org[0], org[1], org[0]+w-1, org[1]+h-1, 1/*front*/, rgb);
+    if ( rgb->GetPointer(0) != pxls)   // Reallocated so nothing was written to dst
+        return false;
+
+    // Flip vertically for OpenCV and swap RGB to BGR in place.
+    for ( int i = 0; i < (h+1)/2; ++i)
+    {
+        cv::Vec3b *top = dst.ptr<cv::Vec3b>(i);
+        cv::Vec3b *bot = dst.ptr<cv::Vec3b>(h-i-1);
+        for ( int j = 0; j < w; ++j)
+        {
+            const cv::Vec3b t = top[j];
+            top[j] = cv::Vec3b( bot[j][2], bot[j][1], bot[j][0]);
+            bot[j] = cv::Vec3b( t[2], t[1], t[0]);
+        }   // end for
+    }   // end for
+    return true;
+}   // end readBGR
+
+
+cv::Mat_<float> r3dvis::readZ( vtkRenderer *ren)
+{
+    const int *org = ren->GetOrigin();
+    const int *sz = ren->GetSize();
+    const int w = sz[0];
+    const int h = sz[1];
+    cv::Mat_<float> zimg( h, w);
+    if ( w <= 0 || h <= 0)
+        return zimg;
+
+    vtkNew<vtkFloatArray> zvals;
+    ren->GetRenderWindow()->GetZbufferData( org[0], org[1], org[0]+w-1, org[1]+h-1, zvals);
+    const float *zbuf = zvals->GetPointer(0);
+    for ( int i = 0; i < h; ++i)   // Flip vertically for OpenCV
+        memcpy( zimg.ptr<float>(h-i-1), &zbuf[size_t(i)*w], w*sizeof(float));
+    return zimg;
+}   // end readZ
+
+
+Eigen::Matrix4d r3dvis::compositeProjection( vtkRenderer *ren)
+{
+    vtkMatrix4x4 *vm = ren->GetActiveCamera()->GetCompositeProjectionTransformMatrix( ren->GetTiledAspectRatio(), 0, 1);
+    Eigen::Matrix4d m;
+    for ( int i = 0; i < 4; ++i)
+        for ( int j = 0; j < 4; ++j)
+            m(i,j) = vm->GetElement(i,j);
+    return m;
+}   // end compositeProjection
+
+
 void r3dvis::printCameraDetails( vtkCamera* cam, std::ostream &os)
 {
     using std::endl;
@@ -536,55 +727,97 @@ cv::Mat_<byte> r3dvis::contrastStretch( const cv::Mat& m, const cv::Mat_<byte> m
 }   // end contrastStretch
 
 
-namespace {
-
-vtkSmartPointer<vtkFloatArray> makeTexturedNormals( const r3d::Curvature &cv)
+vtkSmartPointer<vtkFloatArray> r3dvis::makeNormals( const r3d::Curvature &cv)
 {
-    vtkSmartPointer<vtkFloatArray> narr = vtkSmartPointer<vtkFloatArray>::New();
-    narr->SetNumberOfComponents( 3);
-
     const r3d::Mesh& mesh = cv.mesh();
-    const int nfaces = int(mesh.numFaces());
-    const r3d::MatX3f& nrms = cv.vertexNormals();
-    narr->SetNumberOfTuples( 3*nfaces);
+    vtkSmartPointer<vtkIntArray> pvmap;
+    if ( mesh.numMats() > 0)    // Textured actors have three points per face
+        pvmap = makePointVertexMap( mesh);
+    return makeNormals( cv.vertexNormals(), pvmap);
+}   // end makeNormals
 
-    int i = 0;
-    for ( int fid = 0; fid < nfaces; ++fid)
-    {
-        const int* fvidxs = mesh.fvidxs(fid);
-        narr->SetTuple3( i++, nrms(fvidxs[0],0), nrms(fvidxs[0],1), nrms(fvidxs[0],2));
-        narr->SetTuple3( i++, nrms(fvidxs[1],0), nrms(fvidxs[1],1), nrms(fvidxs[1],2));
-        narr->SetTuple3( i++, nrms(fvidxs[2],0), nrms(fvidxs[2],1), nrms(fvidxs[2],2));
-    }   // end for
 
-    return narr;
-}   // end makeTexturedNormals
+vtkSmartPointer<vtkFloatArray> r3dvis::makeNormals( const r3d::Curvature &cv, const vtkActor *actor)
+{
+    return makeNormals( cv.vertexNormals(), getPointVertexMap( actor));
+}   // end makeNormals
 
 
-vtkSmartPointer<vtkFloatArray> makeNonTexturedNormals( const r3d::Curvature &cv)
+vtkSmartPointer<vtkIntArray> r3dvis::makePointVertexMap( const r3d::Mesh &mesh)
 {
-    vtkSmartPointer<vtkFloatArray> narr = vtkSmartPointer<vtkFloatArray>::New();
-    narr->SetNumberOfComponents( 3);
+    const int nf = int(mesh.numFaces());
+    vtkSmartPointer<vtkIntArray> pvmap = vtkSmartPointer<vtkIntArray>::New();
+    pvmap->SetName( POINT_VERTEX_MAP);
+    pvmap->SetNumberOfComponents(1);
+    pvmap->SetNumberOfTuples( 3*nf);
+    int *out = pvmap->GetPointer(0);
+    for ( int fid = 0; fid < nf; ++fid, out += 3)
+        memcpy( out, mesh.fvidxs(fid), 3*sizeof(int));
+    return pvmap;
+}   // end makePointVertexMap
+
+
+void r3dvis::setPointVertexMap( vtkActor *actor, vtkIntArray *pvmap)
+{
+    vtkPolyData *pd = getPolyData( actor);
+    assert( pd);
+    vtkFieldData *fd = pd->GetFieldData();
+    fd->RemoveArray( POINT_VERTEX_MAP);
+    if ( pvmap)
+    {
+        assert( pvmap->GetNumberOfTuples() == pd->GetNumberOfPoints());
+        pvmap->SetName( POINT_VERTEX_MAP);
+        fd->AddArray( pvmap);
+    }   // end if
+}   // end setPointVertexMap
 
-    const r3d::MatX3f& nrms = cv.vertexNormals();
-    const int nvtxs = nrms.rows();
-    narr->SetNumberOfTuples( nvtxs);
 
-    for ( int vidx = 0; vidx < nvtxs; ++vidx)
-        narr->SetTuple3( vidx, nrms(vidx,0), nrms(vidx,1), nrms(vidx,2));
+vtkIntArray* r3dvis::getPointVertexMap( const vtkActor *actor)
+{
+    vtkPolyData *pd = getPolyData( actor);
+    if ( !pd)
+        return nullptr;
+    return vtkIntArray::SafeDownCast( pd->GetFieldData()->GetAbstractArray( POINT_VERTEX_MAP));
+}   // end getPointVertexMap
 
-    return narr;
-}   // end makeNonTexturedNormals
 
-}   // end namespace
+vtkSmartPointer<vtkFloatArray> r3dvis::gatherVertexTuples( const float *vtuples, int nvtxs, int nc, const vtkIntArray *pvmap)
+{
+    vtkSmartPointer<vtkFloatArray> arr = vtkSmartPointer<vtkFloatArray>::New();
+    arr->SetNumberOfComponents( nc);
+    if ( !pvmap)
+    {
+        arr->SetNumberOfTuples( nvtxs);
+        memcpy( arr->GetPointer(0), vtuples, size_t(nvtxs)*nc*sizeof(float));
+        return arr;
+    }   // end if
 
+    const vtkIdType np = pvmap->GetNumberOfTuples();
+    arr->SetNumberOfTuples( np);
+    const int *vids = const_cast<vtkIntArray*>(pvmap)->GetPointer(0);
+    float *out = arr->GetPointer(0);
+    const size_t tbytes = nc*sizeof(float);
+    for ( vtkIdType i = 0; i < np; ++i, out += nc)
+        memcpy( out, &vtuples[size_t(vids[i])*nc], tbytes);
+    return arr;
+}   // end gatherVertexTuples
 
-vtkSmartPointer<vtkFloatArray> r3dvis::makeNormals( const r3d::Curvature &cv)
+
+vtkSmartPointer<vtkFloatArray> r3dvis::makeNormals( const r3d::MatX3f &nrms, const vtkIntArray *pvmap)
 {
-    vtkSmartPointer<vtkFloatArray> nrms;
-    if ( cv.mesh().numMats() > 0)
-        nrms = makeTexturedNormals( cv);
-    else
-        nrms = makeNonTexturedNormals( cv);
-    return nrms;
+    const int nv = int(nrms.rows());
+    vtkSmartPointer<vtkFloatArray> narr = vtkSmartPointer<vtkFloatArray>::New();
+    narr->SetNumberOfComponents( 3);
+    const vtkIdType np = pvmap ? pvmap->GetNumberOfTuples() : nv;
+    narr->SetNumberOfTuples( np);
+    const int *vids = pvmap ? const_cast<vtkIntArray*>(pvmap)->GetPointer(0) : nullptr;
+    float *out = narr->GetPointer(0);
+    for ( vtkIdType i = 0; i < np; ++i)
+    {
+        const int vid = vids ? vids[i] : int(i);
+        *out++ = nrms(vid,0);
+        *out++ = nrms(vid,1);
+        *out++ = nrms(vid,2);
+    }   // end for
+    return narr;
 }   // end makeNormals
@@ -16,38 +16,172 @@
  ************************************************************************/
 
 #include <VtkVectorField.h>
+#include <vtkCallbackCommand.h>
+#include <vtkDataSetAttributes.h>
 #include <vtkProperty.h>
 #include <VtkTools.h>
+#include <vtkPointData.h>
+#include <algorithm>
+#include <iostream>
+#include <cfloat>
 using r3dvis::VtkVectorField;
+using r3dvis::LookupTable;
 
+namespace {
+const char *VECTORS_NAME = "Vectors";
+const char *MAGNITUDES_NAME = "Magnitudes";
 
-VtkVectorField::Ptr VtkVectorField::create( const vtkPolyData* inputData, bool useNormal)
+// Return a vector array over the given matrix's memory if row major, else a copy.
+vtkSmartPointer<vtkFloatArray> wrapVectors( const r3d::MatX3f &vecs)
 {
-    return Ptr( new VtkVectorField( inputData, useNormal));
+    vtkSmartPointer<vtkFloatArray> arr = vtkSmartPointer<vtkFloatArray>::New();
+    arr->SetName( VECTORS_NAME);
+    arr->SetNumberOfComponents(3);
+    const vtkIdType n = vtkIdType(vecs.rows());
+    if ( r3d::MatX3f::IsRowMajor)
+        arr->SetArray( const_cast<float*>(vecs.data()), 3*n, 1/*don't free*/);
+    else
+    {
+        arr->SetNumberOfTuples( n);
+        Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor> >( arr->GetPointer(0), n, 3) = vecs;
+    }   // end else
+    return arr;
+}   // end wrapVectors
+
+}   // end namespace
+
+
+VtkVectorField::Ptr VtkVectorField::create( const vtkPolyData* inputData, bool useNormal, bool instanced)
+{
+    return Ptr( new VtkVectorField( inputData, useNormal, instanced));
+}   // end create
+
+
+VtkVectorField::Ptr VtkVectorField::create( const r3d::Mesh &mesh, const r3d::MatX3f &vecs, bool instanced, const LookupTable *lut)
+{
+    if ( !mesh.hasSequentialIds())
+    {
+        std::cerr << "[ERROR] r3dvis::VtkVectorField::create: Mesh IDs must be in sequential order!" << std::endl;
+        return nullptr;
+    }   // end if
+
+    const int nv = int(mesh.numVtxs());
+    if ( int(vecs.rows()) != nv)
+    {
+        std::cerr << "[ERROR] r3dvis::VtkVectorField::create: Number of vectors doesn't match number of vertices!" << std::endl;
+        return nullptr;
+    }   // end if
+
+    vtkNew<vtkPoints> points;
+    points->SetDataTypeToFloat();
+    points->SetNumberOfPoints( nv);
+    for ( int i = 0; i < nv; ++i)
+        points->SetPoint( i, &mesh.uvtx(i)[0]);
+
+    vtkNew<vtkPolyData> pd;
+    pd->SetPoints( points);
+    pd->GetPointData()->SetVectors( wrapVectors( vecs));
+
+    float minLen = 0;
+    float maxLen = 0;
+    if ( lut)
+    {
+        vtkNew<vtkFloatArray> mags;
+        mags->SetName( MAGNITUDES_NAME);
+        mags->SetNumberOfTuples( nv);
+        Eigen::Map<Eigen::VectorXf> lens( mags->GetPointer(0), nv);
+        lens = vecs.rowwise().norm();
+        if ( nv > 0)
+        {
+            minLen = lens.minCoeff();
+            maxLen = lens.maxCoeff();
+        }   // end if
+        pd->GetPointData()->SetScalars( mags);
+    }   // end if
+
+    // The glyph pipeline keeps its own reference to the polydata.
+    Ptr vf = Ptr( new VtkVectorField( pd, false, instanced));
+    vf->_scaleByVector();
+    vf->pokeTransform( r3dvis::toVTK( mesh.transformMatrix()));
+    if ( lut)
+    {
+        // A degenerate range (e.g. unit normals) would make the colouring meaningless.
+        if ( maxLen - minLen <= 1e-6f * maxLen)
+            minLen = 0;
+        if ( maxLen <= 0)
+            maxLen = 1;
+        vf->setColourMap( lut->toVTK(), minLen, maxLen);
+    }   // end if
+    return vf;
 }   // end create
 
 
-VtkVectorField::VtkVectorField( const vtkPolyData* inputData, bool useNormal)
+VtkVectorField::Ptr VtkVectorField::create( const r3d::Curvature &cv, bool instanced, const LookupTable *lut)
+{
+    return create( cv.mesh(), cv.vertexNormals(), instanced, lut);
+}   // end create
+
+
+void VtkVectorField::_scaleByVector()
+{
+    if ( _instanced)
+    {
+        _gmapper->SetScaleModeToScaleByMagnitude();
+        _gmapper->SetScaleArray( VECTORS_NAME);
+    }   // end if
+    else
+        _glyph->SetScaleModeToScaleByVector();
+}   // end _scaleByVector
+
+
+VtkVectorField::VtkVectorField( const vtkPolyData* inputData, bool useNormal, bool instanced)
+    : _input(inputData), _instanced(instanced), _observerTag(0), _pxPerGlyph(16)
 {
     _arrow->SetShaftRadius( 0.06);
     _arrow->SetTipLength( 0.30);
     _arrow->SetTipRadius( 0.18);
 
-    _glyph->SetSourceConnection( _arrow->GetOutputPort());
-    _glyph->SetInputData( const_cast<vtkPolyData*>(inputData));
-    _glyph->SetScaleFactor( 1.0);
+    // Only connected in front of the glyphs when subsampling.
+    _mask->SetInputData( const_cast<vtkPolyData*>(inputData));
+    _mask->SetOnRatio(1);
+    _mask->SetMaximumNumberOfPoints( VTK_ID_MAX);
+    _mask->RandomModeOff();
+    _mask->GenerateVerticesOff();
 
-    if ( useNormal)
-        _glyph->SetVectorModeToUseNormal();
+    if ( _instanced)
+    {
+        _gmapper->SetSourceConnection( _arrow->GetOutputPort());
+        _gmapper->SetInputData( const_cast<vtkPolyData*>(inputData));
+        // Scale by the point scalars (if any) like vtkGlyph3D's default.
+        _gmapper->SetScaling( true);
+        _gmapper->SetScaleModeToScaleByMagnitude();
+        _gmapper->SetInputArrayToProcess( vtkGlyph3DMapper::SCALE, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS,
+                                          vtkDataSetAttributes::SCALARS);
+        _gmapper->SetScaleFactor( 1.0);
+        _gmapper->SetOrientationModeToDirection();
+        _gmapper->SetInputArrayToProcess( vtkGlyph3DMapper::ORIENTATION, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS,
+                                          useNormal ? vtkDataSetAttributes::NORMALS : vtkDataSetAttributes::VECTORS);
+        _gmapper->SetScalarVisibility(false);
+        _actor->SetMapper(_gmapper);
+    }   // end if
     else
-        _glyph->SetVectorModeToUseVector();
+    {
+        _glyph->SetSourceConnection( _arrow->GetOutputPort());
+        _glyph->SetInputData( const_cast<vtkPolyData*>(inputData));
+        _glyph->SetScaleFactor( 1.0);
+
+        if ( useNormal)
+            _glyph->SetVectorModeToUseNormal();
+        else
+            _glyph->SetVectorModeToUseVector();
 
-    // Create the actor
-    vtkNew<vtkPolyDataMapper> mapper;
-    mapper->SetInputConnection( _glyph->GetOutputPort());
-    mapper->SetScalarVisibility(false);
+        // Create the actor
+        vtkNew<vtkPolyDataMapper> mapper;
+        mapper->SetInputConnection( _glyph->GetOutputPort());
+        mapper->SetScalarVisibility(false);
 
-    _actor->SetMapper(mapper);
+        _actor->SetMapper(mapper);
+    }   // end else
 
     // Ambient lighting only
     vtkProperty* property = _actor->GetProperty();
@@ -57,10 +191,122 @@ VtkVectorField::VtkVectorField( const vtkPolyData* inputData, bool useNormal)
 }   // end ctor
 
 
+VtkVectorField::~VtkVectorField()
+{
+    if ( _ren)
+        _ren->RemoveObserver( _observerTag);
+}   // end dtor
+
+
+void VtkVectorField::_setGlyphInput( vtkAlgorithmOutput *port)
+{
+    if ( port)
+    {
+        if ( _instanced)
+            _gmapper->SetInputConnection( port);
+        else
+            _glyph->SetInputConnection( port);
+    }   // end if
+    else
+    {
+        if ( _instanced)
+            _gmapper->SetInputData( const_cast<vtkPolyData*>(_input));
+        else
+            _glyph->SetInputData( const_cast<vtkPolyData*>(_input));
+    }   // end else
+}   // end _setGlyphInput
+
+
+void VtkVectorField::setSubsampling( vtkRenderer *ren, int pxPerGlyph)
+{
+    if ( _ren)
+        _ren->RemoveObserver( _observerTag);
+    _observerTag = 0;
+    _ren = ren;
+    _pxPerGlyph = std::max( 1, pxPerGlyph);
+
+    if ( ren)
+    {
+        vtkNew<vtkCallbackCommand> cb;
+        cb->SetCallback( &VtkVectorField::_onRenderStart);
+        cb->SetClientData( this);
+        _observerTag = ren->AddObserver( vtkCommand::StartEvent, cb);
+        _updateStride();
+        _setGlyphInput( _mask->GetOutputPort());
+    }   // end if
+    else
+    {
+        _mask->SetOnRatio(1);
+        _setGlyphInput( nullptr);
+    }   // end else
+}   // end setSubsampling
+
+
+int VtkVectorField::sampleStride() const { return _ren ? _mask->GetOnRatio() : 1;}
+
+
+void VtkVectorField::_onRenderStart( vtkObject*, unsigned long, void *clientData, void*)
+{
+    static_cast<VtkVectorField*>(clientData)->_updateStride();
+}   // end _onRenderStart
+
+
+void VtkVectorField::_updateStride()
+{
+    vtkPolyData *pd = const_cast<vtkPolyData*>(_input);
+    const vtkIdType n = pd->GetNumberOfPoints();
+    const int *sz = _ren->GetSize();
+    if ( n == 0 || sz[0] <= 0 || sz[1] <= 0)
+        return;
+
+    // Project the corners of the transformed input bounds to get the viewport area covered.
+    // Corners at or behind the camera plane don't project sensibly (they'd be mirrored) so
+    // if any are then the bounds straddle the camera and the whole viewport is assumed.
+    double b[6];
+    pd->GetBounds(b);
+    const Eigen::Matrix4d P = compositeProjection( _ren) * toEigen( _actor->GetMatrix()).cast<double>();
+    double x0 = DBL_MAX;
+    double y0 = DBL_MAX;
+    double x1 = -DBL_MAX;
+    double y1 = -DBL_MAX;
+    for ( int i = 0; i < 8; ++i)
+    {
+        const Eigen::Vector4d v = P * Eigen::Vector4d( b[i & 1], b[2 + ((i >> 1) & 1)], b[4 + ((i >> 2) & 1)], 1.0);
+        if ( !(v[3] > 0))
+        {
+            x0 = y0 = 0;
+            x1 = sz[0];
+            y1 = sz[1];
+            break;
+        }   // end if
+        const double x = 0.5 * (v[0] / v[3] + 1.0) * sz[0];
+        const double y = 0.5 * (v[1] / v[3] + 1.0) * sz[1];
+        x0 = std::min( x0, x);
+        y0 = std::min( y0, y);
+        x1 = std::max( x1, x);
+        y1 = std::max( y1, y);
+    }   // end for
+
+    x0 = std::max( x0, 0.0);
+    y0 = std::max( y0, 0.0);
+    x1 = std::min( x1, double(sz[0]));
+    y1 = std::min( y1, double(sz[1]));
+    const double area = std::max( x1 - x0, 0.0) * std::max( y1 - y0, 0.0);
+    const double target = std::max( 1.0, area / double(_pxPerGlyph * _pxPerGlyph));
+
+    // Smallest power of two stride giving no more than the target number of glyphs.
+    int stride = 1;
+    while ( double(n) / stride > target && stride < (1 << 30))
+        stride <<= 1;
+    _mask->SetOnRatio( stride);   // Only modifies the pipeline if changed
+}   // end _updateStride
+
+
 void VtkVectorField::copyProperties( const VtkVectorField& sa)
 {
     setPickable(sa.pickable());
     setScaleFactor(sa.scaleFactor());
+    setArrowResolution(sa.arrowResolution());
     setVisible(sa.visible());
     setColour(sa.colour());
     setOpacity(sa.opacity());
@@ -70,16 +316,34 @@ void VtkVectorField::copyProperties( const VtkVectorField& sa)
 
 void VtkVectorField::setColourMap( const vtkLookupTable *ltab, double minVal, double maxVal)
 {
-    _glyph->SetColorModeToColorByScalar();
+    if ( !_instanced)
+        _glyph->SetColorModeToColorByScalar();
     _actor->GetMapper()->SetLookupTable( const_cast<vtkLookupTable*>(ltab));
     _actor->GetMapper()->SetScalarRange( minVal, maxVal);
     _actor->GetMapper()->SetScalarVisibility( ltab != nullptr);
-    _glyph->Update();
+    if ( !_instanced)
+        _glyph->Update();
 }   // end setColourMap
 
 
-void VtkVectorField::setScaleFactor( double f) { _glyph->SetScaleFactor(f);}
-double VtkVectorField::scaleFactor() const { return _glyph->GetScaleFactor();}
+void VtkVectorField::setScaleFactor( double f)
+{
+    if ( _instanced)
+        _gmapper->SetScaleFactor(f);
+    else
+        _glyph->SetScaleFactor(f);
+}   // end setScaleFactor
+
+double VtkVectorField::scaleFactor() const { return _instanced ? _gmapper->GetScaleFactor() : _glyph->GetScaleFactor();}
+
+
+void VtkVectorField::setArrowResolution( int r)
+{
+    _arrow->SetTipResolution(r);
+    _arrow->SetShaftResolution(r);
+}   // end setArrowResolution
+
+int VtkVectorField::arrowResolution() const { return _arrow->GetTipResolution();}
 
 void VtkVectorField::setPickable( bool v) { _actor->SetPickable(v);}
 bool VtkVectorField::pickable() const { return _actor->GetPickable() != 0;}
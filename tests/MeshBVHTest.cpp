@@ -0,0 +1,378 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+/**
+ * Unit tests for MeshBVH (built with -DBUILD_TESTS=ON and run with ctest).
+ *
+ * Random triangle soups are ray cast with MeshBVH::intersect and every result is
+ * compared against a brute force Möller–Trumbore test of the ray against every face
+ * in double precision. Rays grazing a triangle's edge may legitimately differ between
+ * the two so disagreements are only tolerated where the brute force barycentric
+ * coordinates are within a small margin of an edge.
+ */
+
+#include <r3dvis/MeshBVH.h>
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <cstdlib>
+#include <cmath>
+using r3dvis::MeshBVH;
+using r3d::Vec3f;
+
+namespace {
+
+const double EDGE_MARGIN = 1e-4;    // Barycentric distance from an edge within which disagreement is allowed
+const double MAX_TOLERATED = 0.005; // Max proportion of rays allowed to disagree near edges
+
+struct BruteHit
+{
+    int fid = -1;
+    double t = 0;
+    double u = 0;
+    double v = 0;
+    double margin = 0;  // Smallest barycentric coordinate of the hit
+};  // end struct
+
+
+// Möller–Trumbore in double precision. Returns true if the line through o along d
+// passes through the triangle setting t (in units of d's length) and u,v.
+bool mollerTrumbore( const Eigen::Vector3d &o, const Eigen::Vector3d &d,
+                     const Eigen::Vector3d &v0, const Eigen::Vector3d &v1, const Eigen::Vector3d &v2,
+                     double &t, double &u, double &v)
+{
+    const Eigen::Vector3d e1 = v1 - v0;
+    const Eigen::Vector3d e2 = v2 - v0;
+    const Eigen::Vector3d p = d.cross(e2);
+    const double det = e1.dot(p);
+    if ( fabs(det) < 1e-15)
+        return false;
+    const double idet = 1.0 / det;
+    const Eigen::Vector3d s = o - v0;
+    u = s.dot(p) * idet;
+    const Eigen::Vector3d q = s.cross(e1);
+    v = d.dot(q) * idet;
+    t = e2.dot(q) * idet;
+    return u >= 0 && v >= 0 && u + v <= 1;
+}   // end mollerTrumbore
+
+
+// A face's vertices in world space.
+void worldFace( const r3d::Mesh &mesh, const r3d::Mat4f &T, int fid, Eigen::Vector3d vs[3])
+{
+    const int *fvidxs = mesh.fvidxs(fid);
+    for ( int i = 0; i < 3; ++i)
+        vs[i] = (T * mesh.uvtx(fvidxs[i]).homogeneous()).hnormalized().cast<double>();
+}   // end worldFace
+
+
+// Nearest hit at a distance of at least tmin along the ray by testing every face.
+BruteHit bruteForce( const r3d::Mesh &mesh, const r3d::Mat4f &T, const Vec3f &origin, const Vec3f &dir, float tmin)
+{
+    BruteHit best;
+    const Eigen::Vector3d o = origin.cast<double>();
+    const Eigen::Vector3d d = dir.cast<double>().normalized();
+    const int nf = int(mesh.numFaces());
+    for ( int fid = 0; fid < nf; ++fid)
+    {
+        Eigen::Vector3d vs[3];
+        worldFace( mesh, T, fid, vs);
+        double t, u, v;
+        if ( mollerTrumbore( o, d, vs[0], vs[1], vs[2], t, u, v) && t >= tmin && (best.fid < 0 || t < best.t))
+        {
+            best.fid = fid;
+            best.t = t;
+            best.u = u;
+            best.v = v;
+            best.margin = std::min( std::min( u, v), 1.0 - u - v);
+        }   // end if
+    }   // end for
+    return best;
+}   // end bruteForce
+
+
+// Smallest barycentric coordinate (negative if outside) of the given face along the ray.
+double faceMargin( const r3d::Mesh &mesh, const r3d::Mat4f &T, int fid, const Vec3f &origin, const Vec3f &dir)
+{
+    Eigen::Vector3d vs[3];
+    worldFace( mesh, T, fid, vs);
+    double t, u, v;
+    mollerTrumbore( origin.cast<double>(), dir.cast<double>().normalized(), vs[0], vs[1], vs[2], t, u, v);
+    return std::min( std::min( u, v), 1.0 - u - v);
+}   // end faceMargin
+
+
+// A soup of nfaces random triangles with sides up to about size inside the unit cube.
+r3d::Mesh::Ptr makeSoup( std::mt19937 &rng, int nfaces, float size)
+{
+    std::uniform_real_distribution<float> unit( 0.0f, 1.0f);
+    std::uniform_real_distribution<float> off( -size, size);
+    r3d::Mesh::Ptr mesh = r3d::Mesh::create();
+    for ( int i = 0; i < nfaces; ++i)
+    {
+        const Vec3f c( unit(rng), unit(rng), unit(rng));
+        int vids[3];
+        for ( int j = 0; j < 3; ++j)
+        {
+            const Vec3f p = c + Vec3f( off(rng), off(rng), off(rng));
+            vids[j] = mesh->addVertex( p[0], p[1], p[2]);
+        }   // end for
+        mesh->addFace( vids[0], vids[1], vids[2]);
+    }   // end for
+    return mesh;
+}   // end makeSoup
+
+
+// Rays from random points on a sphere of radius 3 about the (transformed) centre of the unit
+// cube towards random points in it with a tenth of the rays in random directions. Directions
+// have random lengths since intersect must normalise them.
+void makeRays( std::mt19937 &rng, int n, const r3d::Mat4f &T, std::vector<Vec3f> &origins, std::vector<Vec3f> &dirs)
+{
+    std::uniform_real_distribution<float> unit( 0.0f, 1.0f);
+    std::normal_distribution<float> gauss;
+    const Vec3f c = (T * Vec3f( 0.5f, 0.5f, 0.5f).homogeneous()).hnormalized();
+    origins.resize(n);
+    dirs.resize(n);
+    for ( int i = 0; i < n; ++i)
+    {
+        origins[i] = c + 3.0f * Vec3f( gauss(rng), gauss(rng), gauss(rng)).normalized();
+        Vec3f d;
+        if ( i % 10 == 0)
+            d = Vec3f( gauss(rng), gauss(rng), gauss(rng));
+        else
+            d = (T * Vec3f( unit(rng), unit(rng), unit(rng)).homogeneous()).hnormalized() - origins[i];
+        dirs[i] = d.normalized() * (0.1f + 10.0f * unit(rng));
+    }   // end for
+}   // end makeRays
+
+
+// Check the BVH hit against brute force returning false if they disagree. Sets tolerated true
+// if they disagree but only because the ray grazes an edge.
+bool check( const r3d::Mesh &mesh, const r3d::Mat4f &T, const Vec3f &o, const Vec3f &d, float tmin,
+            bool found, const MeshBVH::Hit &hit, bool &tolerated)
+{
+    tolerated = false;
+    const BruteHit bf = bruteForce( mesh, T, o, d, tmin);
+    if ( found != (hit.fid >= 0))
+        return false;
+
+    if ( bf.fid < 0 && hit.fid < 0)
+        return true;
+
+    if ( bf.fid < 0 || hit.fid < 0)
+    {
+        // One missed so the ray must graze the edge of the face the other hit.
+        tolerated = bf.fid >= 0 ? bf.margin < EDGE_MARGIN : fabs( faceMargin( mesh, T, hit.fid, o, d)) < EDGE_MARGIN;
+        return tolerated;
+    }   // end if
+
+    const double ttol = 1e-4 * (1.0 + bf.t);
+    if ( fabs( hit.t - bf.t) > ttol)
+    {
+        // Hit different faces at different distances so the nearer must be at an edge.
+        tolerated = hit.t > bf.t ? bf.margin < EDGE_MARGIN : fabs( faceMargin( mesh, T, hit.fid, o, d)) < EDGE_MARGIN;
+        return tolerated;
+    }   // end if
+
+    // Hit position must be t along the normalised ray.
+    const Vec3f pos = o + hit.t * d.normalized();
+    if ( (hit.pos - pos).norm() > 1e-4f * (1.0f + hit.t))
+        return false;
+
+    // Coincident hits on different faces (e.g. a shared edge) can't be compared further.
+    if ( hit.fid == bf.fid && (fabs( hit.u - bf.u) > 1e-3 || fabs( hit.v - bf.v) > 1e-3))
+        return false;
+    return true;
+}   // end check
+
+
+// Cast the rays singly and as a batch comparing against brute force. Returns the number of failures.
+int testRays( const std::string &name, const r3d::Mesh &mesh, const MeshBVH &bvh,
+              const std::vector<Vec3f> &origins, const std::vector<Vec3f> &dirs, float tmin=0)
+{
+    int failures = 0;
+    int tolerated = 0;
+    size_t nhits = 0;
+    const size_t n = origins.size();
+    for ( size_t i = 0; i < n; ++i)
+    {
+        MeshBVH::Hit hit;
+        const bool found = bvh.intersect( origins[i], dirs[i], hit, tmin);
+        bool tol;
+        if ( !check( mesh, bvh.transform(), origins[i], dirs[i], tmin, found, hit, tol))
+        {
+            if ( failures++ < 5)
+                std::cerr << "[FAILED] " << name << ": ray " << i << " hit face " << hit.fid
+                          << " at " << hit.t << std::endl;
+        }   // end if
+        tolerated += tol ? 1 : 0;
+        nhits += found ? 1 : 0;
+    }   // end for
+
+    if ( tolerated > MAX_TOLERATED * n)
+    {
+        std::cerr << "[FAILED] " << name << ": " << tolerated << " rays disagree at edges" << std::endl;
+        failures++;
+    }   // end if
+
+    if ( tmin == 0)  // Batch casting must give exactly the same hits as single rays
+    {
+        std::vector<MeshBVH::Hit> hits;
+        const size_t bhits = bvh.intersect( origins, dirs, hits, 4);
+        if ( hits.size() != n || bhits != nhits)
+        {
+            std::cerr << "[FAILED] " << name << ": batch found " << bhits << " hits not " << nhits << std::endl;
+            failures++;
+        }   // end if
+        for ( size_t i = 0; i < hits.size(); ++i)
+        {
+            MeshBVH::Hit hit;
+            bvh.intersect( origins[i], dirs[i], hit);
+            if ( hits[i].fid != hit.fid || hits[i].t != hit.t)
+            {
+                std::cerr << "[FAILED] " << name << ": batch ray " << i << " differs" << std::endl;
+                failures++;
+                break;
+            }   // end if
+        }   // end for
+    }   // end if
+
+    std::cout << "  " << name << ": " << nhits << "/" << n << " hits, "
+              << tolerated << " edge grazing, " << failures << " failures" << std::endl;
+    return failures;
+}   // end testRays
+
+
+int testSoup( std::mt19937 &rng)
+{
+    const r3d::Mesh::Ptr mesh = makeSoup( rng, 2000, 0.1f);
+    const MeshBVH bvh( *mesh);
+    std::vector<Vec3f> origins, dirs;
+    makeRays( rng, 4000, bvh.transform(), origins, dirs);
+    return testRays( "soup", *mesh, bvh, origins, dirs);
+}   // end testSoup
+
+
+// Large enough that subtrees are built in parallel.
+int testParallelBuild( std::mt19937 &rng)
+{
+    const r3d::Mesh::Ptr mesh = makeSoup( rng, 50000, 0.02f);
+    const MeshBVH bvh( *mesh, 4);
+    if ( bvh.numFaces() != mesh->numFaces())
+    {
+        std::cerr << "[FAILED] parallel build: BVH has " << bvh.numFaces() << " faces" << std::endl;
+        return 1;
+    }   // end if
+    std::vector<Vec3f> origins, dirs;
+    makeRays( rng, 500, bvh.transform(), origins, dirs);
+    return testRays( "parallel build", *mesh, bvh, origins, dirs);
+}   // end testParallelBuild
+
+
+int testTransform( std::mt19937 &rng)
+{
+    const r3d::Mesh::Ptr mesh = makeSoup( rng, 1000, 0.1f);
+    MeshBVH bvh( *mesh);
+    r3d::Mat4f T = r3d::Mat4f::Identity();
+    T.block<3,3>(0,0) = Eigen::AngleAxisf( 0.7f, Vec3f( 1, 2, 3).normalized()).toRotationMatrix();
+    T.block<3,1>(0,3) = Vec3f( 0.3f, -1.2f, 2.0f);
+    bvh.setTransform( T);
+    std::vector<Vec3f> origins, dirs;
+    makeRays( rng, 2000, T, origins, dirs);
+    return testRays( "transformed", *mesh, bvh, origins, dirs);
+}   // end testTransform
+
+
+// Rays from inside the soup must ignore hits nearer than tmin.
+int testTMin( std::mt19937 &rng)
+{
+    const r3d::Mesh::Ptr mesh = makeSoup( rng, 2000, 0.1f);
+    const MeshBVH bvh( *mesh);
+    std::uniform_real_distribution<float> unit( 0.0f, 1.0f);
+    std::normal_distribution<float> gauss;
+    std::vector<Vec3f> origins( 2000), dirs( 2000);
+    for ( size_t i = 0; i < origins.size(); ++i)
+    {
+        origins[i] = Vec3f( unit(rng), unit(rng), unit(rng));
+        dirs[i] = Vec3f( gauss(rng), gauss(rng), gauss(rng));
+    }   // end for
+    return testRays( "tmin", *mesh, bvh, origins, dirs, 0.2f);
+}   // end testTMin
+
+
+int testDegenerate( std::mt19937 &rng)
+{
+    int failures = 0;
+    MeshBVH::Hit hit;
+
+    const r3d::Mesh::Ptr mesh = makeSoup( rng, 100, 0.1f);
+    const MeshBVH bvh( *mesh);
+    if ( bvh.intersect( Vec3f( 0.5f, 0.5f, -3.0f), Vec3f::Zero(), hit) || hit.fid != -1)
+    {
+        std::cerr << "[FAILED] degenerate: zero length direction hit" << std::endl;
+        failures++;
+    }   // end if
+
+    const r3d::Mesh::Ptr empty = r3d::Mesh::create();
+    const MeshBVH ebvh( *empty);
+    if ( ebvh.numFaces() != 0 || ebvh.intersect( Vec3f( 0, 0, -1), Vec3f( 0, 0, 1), hit) || hit.fid != -1)
+    {
+        std::cerr << "[FAILED] degenerate: empty mesh hit" << std::endl;
+        failures++;
+    }   // end if
+
+    // A single axis aligned triangle hit head on and along its plane.
+    const r3d::Mesh::Ptr tri = r3d::Mesh::create();
+    tri->addFace( tri->addVertex( 0, 0, 0), tri->addVertex( 1, 0, 0), tri->addVertex( 0, 1, 0));
+    const MeshBVH tbvh( *tri);
+    if ( !tbvh.intersect( Vec3f( 0.25f, 0.25f, 2.0f), Vec3f( 0, 0, -5), hit) || hit.fid != 0
+            || fabs( hit.t - 2.0f) > 1e-6f || fabs( hit.u - 0.25f) > 1e-6f || fabs( hit.v - 0.25f) > 1e-6f)
+    {
+        std::cerr << "[FAILED] degenerate: missed single triangle" << std::endl;
+        failures++;
+    }   // end if
+    if ( tbvh.intersect( Vec3f( -1, 0.25f, 0), Vec3f( 1, 0, 0), hit))
+    {
+        std::cerr << "[FAILED] degenerate: hit triangle edge on" << std::endl;
+        failures++;
+    }   // end if
+
+    std::cout << "  degenerate: " << failures << " failures" << std::endl;
+    return failures;
+}   // end testDegenerate
+
+}   // end namespace
+
+
+int main()
+{
+    std::mt19937 rng( 2026);
+    std::cout << "MeshBVH::intersect vs brute force:" << std::endl;
+    int failures = 0;
+    failures += testSoup( rng);
+    failures += testParallelBuild( rng);
+    failures += testTransform( rng);
+    failures += testTMin( rng);
+    failures += testDegenerate( rng);
+    if ( failures > 0)
+    {
+        std::cerr << failures << " MeshBVH test failures" << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+    std::cout << "All MeshBVH tests passed" << std::endl;
+    return EXIT_SUCCESS;
+}   // end main
@@ -0,0 +1,38 @@
+/************************************************************************
+ * Copyright (C) 2026 Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+/**
+ * Render worker process launched by r3dvis::RenderFarm. The only argument
+ * is the file descriptor of the Unix domain socket connected to the client.
+ */
+
+#include <r3dvis/RenderFarm.h>
+#include <iostream>
+#include <cstdlib>
+
+int main( int argc, char **argv)
+{
+    if ( argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " socket_fd" << std::endl;
+        std::cerr << "Launched by r3dvis::RenderFarm - not intended to be run directly." << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+
+    const int fd = atoi( argv[1]);
+    return r3dvis::RenderFarm::serve( fd);
+}   // end main